@@ -0,0 +1,202 @@
+/**
+ * GUI library for "mac/μac"
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ **/
+
+#include "Arena.h"
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * Initialise an empty arena
+	 */
+	void arenaInit( Arena& arena ){
+		arena.regionCount = 0;
+		arena.failures = 0;
+	}
+
+	/**
+	 * Add a memory region to an arena
+	 */
+	boolean arenaAddRegion( Arena& arena, void* memory, uint32_t size, MemoryHint speed ){
+		if (arena.regionCount >= MAC_ARENA_REGIONS) return false;
+		MemoryRegion& r = arena.regions[ arena.regionCount++ ];
+		r.base = (uint8_t*)memory;
+		r.size = size;
+		r.speed = speed;
+		r.used = 0;
+		r.highWater = 0;
+		return true;
+	}
+
+	/**
+	 * Bump allocate from one region
+	 */
+	static void* regionAlloc( MemoryRegion& r, uint32_t size, uint32_t align ){
+		uintptr_t start = ((uintptr_t)r.base + r.used + align - 1) & ~(uintptr_t)(align - 1);
+		uint32_t end = (uint32_t)(start - (uintptr_t)r.base) + size;
+		if (end > r.size) return 0;
+		r.used = end;
+		if (end > r.highWater) r.highWater = end;
+		return (void*)start;
+	}
+
+	/**
+	 * Allocate memory from an arena
+	 */
+	void* arenaAlloc( Arena& arena, uint32_t size, MemoryHint hint, uint32_t align ){
+		void* p;
+		// Hinted regions first, then the rest
+		for (uint8_t pass = 0; pass < 2; pass++){
+			for (uint8_t i = 0; i < arena.regionCount; i++){
+				MemoryRegion& r = arena.regions[i];
+				boolean match = (hint == MR_ANY) || (r.speed == hint);
+				if ((pass == 0) != match) continue;
+				if ((p = regionAlloc( r, size, align ))) return p;
+			}
+		}
+		arena.failures++;
+		return 0;
+	}
+
+	/**
+	 * Get a mark that arenaRelease can free back to
+	 */
+	ArenaMark arenaMark( const Arena& arena ){
+		ArenaMark mark;
+		for (uint8_t i = 0; i < MAC_ARENA_REGIONS; i++) mark.used[i] = (i < arena.regionCount) ? arena.regions[i].used : 0;
+		return mark;
+	}
+
+	/**
+	 * Free everything allocated since a mark
+	 */
+	void arenaRelease( Arena& arena, const ArenaMark& mark ){
+		for (uint8_t i = 0; i < arena.regionCount; i++){
+			if (mark.used[i] < arena.regions[i].used) arena.regions[i].used = mark.used[i];
+		}
+	}
+
+	/**
+	 * Free everything in an arena
+	 */
+	void arenaReset( Arena& arena ){
+		for (uint8_t i = 0; i < arena.regionCount; i++) arena.regions[i].used = 0;
+	}
+
+	/**
+	 * Get the number of bytes allocated in an arena
+	 */
+	uint32_t arenaUsed( const Arena& arena, MemoryHint hint ){
+		uint32_t total = 0;
+		for (uint8_t i = 0; i < arena.regionCount; i++){
+			if ((hint == MR_ANY) || (arena.regions[i].speed == hint)) total += arena.regions[i].used;
+		}
+		return total;
+	}
+
+	/**
+	 * Get the most bytes ever allocated in an arena
+	 */
+	uint32_t arenaHighWater( const Arena& arena, MemoryHint hint ){
+		uint32_t total = 0;
+		for (uint8_t i = 0; i < arena.regionCount; i++){
+			if ((hint == MR_ANY) || (arena.regions[i].speed == hint)) total += arena.regions[i].highWater;
+		}
+		return total;
+	}
+
+	/**
+	 * Round a slot size up so that every slot can hold an aligned free list pointer
+	 */
+	static inline uint32_t poolSlotSize( uint32_t slotSize ){
+		return max( (slotSize + POOL_ALIGN - 1) & ~(POOL_ALIGN - 1), (uint32_t)sizeof(void*) );
+	}
+
+	/**
+	 * Initialise a pool in memory supplied by the caller
+	 */
+	void poolInit( Pool& pool, void* memory, uint32_t slotSize, uint32_t slotCount ){
+		pool.memory = (uint8_t*)memory;
+		pool.slotSize = poolSlotSize( slotSize );
+		pool.slotCount = slotCount;
+		pool.used = 0;
+		pool.highWater = 0;
+		// Thread the free list through the slots, in order
+		pool.freeList = slotCount ? pool.memory : 0;
+		for (uint32_t i = 0; i < slotCount; i++){
+			uint8_t* slot = pool.memory + i * pool.slotSize;
+			*(void**)slot = (i + 1 < slotCount) ? slot + pool.slotSize : 0;
+		}
+	}
+
+	/**
+	 * Initialise a pool with memory from an arena
+	 */
+	boolean poolCreate( Pool& pool, Arena& arena, uint32_t slotSize, uint32_t slotCount, MemoryHint hint ){
+		void* memory = arenaAlloc( arena, poolSlotSize( slotSize ) * slotCount, hint, POOL_ALIGN );
+		if (!memory) return false;
+		poolInit( pool, memory, slotSize, slotCount );
+		return true;
+	}
+
+	/**
+	 * Allocate a slot
+	 */
+	void* poolAlloc( Pool& pool ){
+		void* slot = pool.freeList;
+		if (!slot) return 0;
+		pool.freeList = *(void**)slot;
+		if (++pool.used > pool.highWater) pool.highWater = pool.used;
+		return slot;
+	}
+
+	/**
+	 * Free a slot
+	 */
+	void poolFree( Pool& pool, void* slot ){
+		if (!slot) return;
+		*(void**)slot = pool.freeList;
+		pool.freeList = slot;
+		pool.used--;
+	}
+
+	/**
+	 * Create a bitmap with pixel memory from an arena
+	 */
+	boolean bitmapCreate(
+		Bitmap& bitmap,
+		Arena& arena,
+		PixelFormat pixelFormat,
+		uint16_t width,
+		uint16_t height,
+		MemoryHint hint
+	){
+		uint32_t size = width * height * pixelFormatByteWidth( pixelFormat );
+		uint8_t* data = (uint8_t*)arenaAlloc( arena, size, hint );
+		if (!data) return false;
+		bitmap.pixelFormat = pixelFormat;
+		bitmap.transparentColor = (pixelFormat == mac::PF_565) ? (uint32_t)RGB565_Transparent : ((pixelFormat == mac::PF_888) ? (uint32_t)RGB888_Transparent : 0);
+		bitmap.dataSize = size;
+		bitmap.width = width;
+		bitmap.height = height;
+		bitmap.data = data;
+		return true;
+	}
+
+	/**
+	 * Create a pool with one slot per tile of a tilemap's size
+	 */
+	boolean tilePoolCreate( Pool& pool, Arena& arena, const Tilemap& tilemap, uint32_t slotCount, MemoryHint hint ){
+		return poolCreate( pool, arena, tilemap.tileStride, slotCount, hint );
+	}
+
+} // ns
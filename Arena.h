@@ -0,0 +1,240 @@
+/**
+ * Deterministic memory for runtime bitmaps, caches and render targets
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ *
+ * MIT LICENCE
+ * -----------
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef _MAC_ARENAH_
+#define _MAC_ARENAH_ 1
+
+#include "Bitmap.h"
+
+/**
+ * Largest number of memory regions in an arena
+ **/
+#ifndef MAC_ARENA_REGIONS
+	#define MAC_ARENA_REGIONS 4
+#endif
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * Where memory should come from. On Teensy 4.x, fast memory is DTCM (normal variables)
+	 * and slow memory is OCRAM (DMAMEM) or external PSRAM (EXTMEM).
+	 **/
+	typedef enum {
+		MR_FAST				= 0,	// Fast memory (for buffers that are drawn from or into often)
+		MR_SLOW				= 1,	// Slow memory (for large buffers that are used less often)
+		MR_ANY				= 2		// Any region
+	} MemoryHint;
+
+	/**
+	 * A block of memory supplied by the caller, for an arena to allocate from
+	 **/
+	typedef struct MemoryRegionS {
+		uint8_t* base;						// Start of the memory
+		uint32_t size;						// Size of the memory in bytes
+		MemoryHint speed;					// MR_FAST or MR_SLOW
+		uint32_t used;						// Bytes allocated
+		uint32_t highWater;					// Most bytes ever allocated at once
+	} MemoryRegion;
+
+	/**
+	 * A bump allocator over one or more memory regions. Allocation is O(1) and never
+	 * fragments. Memory is freed all at once, back to a mark, so an arena suits things that
+	 * live for a whole screen (bitmaps, caches, render targets) or for one frame (scratch).
+	 **/
+	typedef struct ArenaS {
+		MemoryRegion regions[ MAC_ARENA_REGIONS ];	// The regions
+		uint8_t regionCount;				// Number of regions
+		uint32_t failures;					// Number of allocations that did not fit
+	} Arena;
+
+	/**
+	 * A point in an arena to release back to
+	 **/
+	typedef struct ArenaMarkS {
+		uint32_t used[ MAC_ARENA_REGIONS ];	// Bytes allocated in each region
+	} ArenaMark;
+
+	/**
+	 * Initialise an empty arena
+	 * @param arena 	The arena
+	 */
+	void arenaInit( Arena& arena );
+
+	/**
+	 * Add a memory region to an arena
+	 * @param  arena 	The arena
+	 * @param  memory 	The memory
+	 * @param  size 	Size of the memory in bytes
+	 * @param  speed 	MR_FAST or MR_SLOW
+	 * @return       	False if the arena already has MAC_ARENA_REGIONS regions
+	 */
+	boolean arenaAddRegion( Arena& arena, void* memory, uint32_t size, MemoryHint speed );
+
+	/**
+	 * Allocate memory from an arena. Regions of the hinted speed are tried first, then any
+	 * other region.
+	 * @param  arena 	The arena
+	 * @param  size 	Number of bytes
+	 * @param  hint 	Where the memory should come from
+	 * @param  align 	Alignment in bytes (a power of 2)
+	 * @return       	The memory, or 0 if there is not enough
+	 */
+	void* arenaAlloc( Arena& arena, uint32_t size, MemoryHint hint = MR_ANY, uint32_t align = 4 );
+
+	/**
+	 * Get a mark that arenaRelease can free back to. For per-frame scratch memory, mark at the
+	 * start of the frame and release at the end.
+	 * @param  arena 	The arena
+	 * @return       	The mark
+	 */
+	ArenaMark arenaMark( const Arena& arena );
+
+	/**
+	 * Free everything allocated since a mark
+	 * @param arena 	The arena
+	 * @param mark 		The mark
+	 */
+	void arenaRelease( Arena& arena, const ArenaMark& mark );
+
+	/**
+	 * Free everything in an arena. The high-water marks are kept.
+	 * @param arena 	The arena
+	 */
+	void arenaReset( Arena& arena );
+
+	/**
+	 * Get the number of bytes allocated in an arena
+	 * @param  arena 	The arena
+	 * @param  hint 	Only count regions of this speed (MR_ANY for all)
+	 * @return       	Bytes allocated
+	 */
+	uint32_t arenaUsed( const Arena& arena, MemoryHint hint = MR_ANY );
+
+	/**
+	 * Get the most bytes ever allocated in an arena, added up over its regions
+	 * @param  arena 	The arena
+	 * @param  hint 	Only count regions of this speed (MR_ANY for all)
+	 * @return       	The high-water mark in bytes
+	 */
+	uint32_t arenaHighWater( const Arena& arena, MemoryHint hint = MR_ANY );
+
+	/**
+	 * Alignment of pool slots. Each free slot holds a pointer, so slots are aligned for one,
+	 * and to at least 4 bytes for pixel data.
+	 **/
+	const uint32_t POOL_ALIGN = (alignof(void*) > 4) ? alignof(void*) : 4;
+
+	/**
+	 * A pool of fixed-size slots (for example converted tiles). Slots are allocated and freed
+	 * in any order in O(1) through a free list kept inside the free slots.
+	 **/
+	typedef struct PoolS {
+		uint8_t* memory;					// The slots
+		uint32_t slotSize;					// Size of each slot in bytes (rounded up to a multiple of POOL_ALIGN)
+		uint32_t slotCount;					// Number of slots
+		void* freeList;						// First free slot
+		uint32_t used;						// Number of slots allocated
+		uint32_t highWater;					// Most slots ever allocated at once
+	} Pool;
+
+	/**
+	 * Initialise a pool in memory supplied by the caller
+	 * @param  pool 		The pool
+	 * @param  memory 		The memory (aligned to POOL_ALIGN, slotSize x slotCount bytes after rounding)
+	 * @param  slotSize 	Size of each slot in bytes (rounded up to a multiple of POOL_ALIGN)
+	 * @param  slotCount 	Number of slots
+	 */
+	void poolInit( Pool& pool, void* memory, uint32_t slotSize, uint32_t slotCount );
+
+	/**
+	 * Initialise a pool with memory from an arena
+	 * @param  pool 		The pool
+	 * @param  arena 		The arena
+	 * @param  slotSize 	Size of each slot in bytes (rounded up to a multiple of POOL_ALIGN)
+	 * @param  slotCount 	Number of slots
+	 * @param  hint 		Where the memory should come from
+	 * @return 				False if the arena did not have enough memory
+	 */
+	boolean poolCreate( Pool& pool, Arena& arena, uint32_t slotSize, uint32_t slotCount, MemoryHint hint = MR_ANY );
+
+	/**
+	 * Allocate a slot
+	 * @param  pool 	The pool
+	 * @return      	The slot, or 0 if all slots are in use
+	 */
+	void* poolAlloc( Pool& pool );
+
+	/**
+	 * Free a slot
+	 * @param pool 		The pool
+	 * @param slot 		The slot (from poolAlloc)
+	 */
+	void poolFree( Pool& pool, void* slot );
+
+	/**
+	 * Create a bitmap with pixel memory from an arena. The pixels are not cleared.
+	 * @param  bitmap 		(out) The bitmap
+	 * @param  arena 		The arena
+	 * @param  pixelFormat 	The pixel format
+	 * @param  width 		Width in pixels
+	 * @param  height 		Height in pixels
+	 * @param  hint 		Where the memory should come from
+	 * @return 				False if the arena did not have enough memory
+	 */
+	boolean bitmapCreate(
+		Bitmap& bitmap,
+		Arena& arena,
+		PixelFormat pixelFormat,
+		uint16_t width,
+		uint16_t height,
+		MemoryHint hint = MR_ANY
+	);
+
+	/**
+	 * Create a pool with one slot per tile of a tilemap's size, for caching converted or
+	 * decompressed tiles
+	 * @param  pool 		The pool
+	 * @param  arena 		The arena
+	 * @param  tilemap 		The tilemap (sets the slot size)
+	 * @param  slotCount 	Number of tiles to make room for
+	 * @param  hint 		Where the memory should come from
+	 * @return 				False if the arena did not have enough memory
+	 */
+	boolean tilePoolCreate( Pool& pool, Arena& arena, const Tilemap& tilemap, uint32_t slotCount, MemoryHint hint = MR_FAST );
+
+} // ns
+
+#endif
@@ -32,6 +32,14 @@
 
 #include <Arduino.h>
 
+/**
+ * Host builds (the simulator, tools and server-side renderers) are anything not built by
+ * the Arduino toolchain. Features that need threads or files are only compiled on the host.
+ **/
+#if !defined(ARDUINO) && !defined(MAC_HOST)
+	#define MAC_HOST 1
+#endif
+
 /**
  * This file is part of the mac (or μac) "Microprocessor App Creator" library.
  * mac is a project that enables creating beautiful and useful apps on the
@@ -437,12 +445,51 @@ namespace mac{
 		uint32_t tileStride;				// Stride of each tile in bytes
 	} Tilemap;
 
+	/**
+	 * Where a sprite is in an atlas. Sprites are trimmed to their visible pixels, so the
+	 * offset says where the trimmed pixels were in the original cell.
+	 **/
+	typedef struct AtlasRectS {
+		uint16_t x;							// Left edge in the atlas bitmap
+		uint16_t y;							// Top edge in the atlas bitmap
+		uint16_t w;							// Width of the trimmed sprite (0 if fully transparent)
+		uint16_t h;							// Height of the trimmed sprite (0 if fully transparent)
+		int16_t offsetX;					// X offset of the trimmed sprite within its cell
+		int16_t offsetY;					// Y offset of the trimmed sprite within its cell
+	} AtlasRect;
+
+	/**
+	 * Holds details of a sprite atlas in flash memory: sprites of different sizes packed into
+	 * one bitmap, and a table of where each one is
+	 **/
+	typedef struct AtlasS {
+		Bitmap bitmap;						// The packed sprites
+		const AtlasRect* rects;				// Where each sprite is in the bitmap
+		uint32_t count;						// Number of sprites
+		uint32_t cellWidth;					// Width of each sprite before it was trimmed
+		uint32_t cellHeight;				// Height of each sprite before it was trimmed
+	} Atlas;
+
+	/**
+	 * Packed 1-bit opacity masks, one per tile (or one for a bitmap). Each row of a mask is
+	 * stored in 32-bit words with the leftmost pixel in the top bit. Unused bits at the end of
+	 * a row are always 0. See Collision.h.
+	 **/
+	typedef struct HitMaskS {
+		const uint32_t* data;				// The mask words
+		uint32_t width;						// Width of each mask in pixels
+		uint32_t height;					// Height of each mask in pixels
+		uint32_t count;						// Number of masks
+		uint32_t rowWords;					// Number of words in each row of a mask
+		uint32_t stride;					// Number of words in each mask
+	} HitMask;
+
 	/**
 	 * Clamp alpha to range 0.0 - 1.0
 	 * @param  alpha 		The value to clamp
 	 * @return       The clamped value in the range 0.0 - 1.0
 	 */
-	inline alpha alphaClamp( alpha a ){
+	constexpr alpha alphaClamp( alpha a ){
 		return (a<0)?0:(a>1)?1:a;
 	}
 
@@ -511,7 +558,7 @@ namespace mac{
 	 * @param	g		Green component
 	 * @param	b		Blue component
 	 **/
-	inline color565 convertRGBto565(
+	constexpr color565 convertRGBto565(
 		uint8_t r,
 		uint8_t g,
 		uint8_t b
@@ -549,7 +596,7 @@ namespace mac{
 	 * Convert ARGB 32bit to RGB565 16bit format
 	 * @param	c			The RGB 24-bit colour (alpha is ignored)
 	 **/
-	inline color565 convert888to565(
+	constexpr color565 convert888to565(
 		color888 c
 	){
 		return ((c >> 8) & 0xF800) | ((c >> 5) & 0x07E0) | ((c >> 3) & 0x1F);
@@ -559,7 +606,7 @@ namespace mac{
 	 * Convert grayscale 8-bit to RGB565 16-bit format
 	 * @param	c			The grayscale color (0-255)
 	 **/
-	inline color565 convert8to565(
+	constexpr color565 convert8to565(
 		uint8_t c
 	){
 		return ((c & 0xF8) << 8) | ((c & 0xFC) << 3) | ((c & 0xF8) >> 3);
@@ -569,7 +616,7 @@ namespace mac{
 	 * Convert mono 1-bit to RGB565 16-bit format
 	 * @param	c			The mono color (0,1)
 	 **/
-	inline color565 convert1to565(
+	constexpr color565 convert1to565(
 		uint8_t c
 	){
 		return (c & 0b1)?RGB565_White:RGB565_Black;
@@ -620,7 +667,7 @@ namespace mac{
 	 * Calculate the pre-multiplied value of an RGB565 color for fast blending
 	 * @param c  	RGB565 color
 	 */
-	inline uint32_t colorPrepare565( color565 c ){
+	constexpr uint32_t colorPrepare565( color565 c ){
 		return (((uint32_t)c | ((uint32_t)c << 16)) & 0b00000111111000001111100000011111);
 	}
 
@@ -628,7 +675,7 @@ namespace mac{
 	 * Calculate the pre-multiplied value of a 24-bit RGB color for 565 fast blending
 	 * @param c  	RGB888 color
 	 */
-	inline uint32_t colorPrepare565( color888 c ){
+	constexpr uint32_t colorPrepare565( color888 c ){
 		return ((c & 0xF80000) >> 8) | ((c & 0xFC00) << 11) | ((c & 0xF8) >> 3);
 	}
 
@@ -638,7 +685,7 @@ namespace mac{
 	 * @param g  		Green color component
 	 * @param b  		Blue color component
 	 */
-	inline uint32_t colorPrepare565( uint8_t r, uint8_t g, uint8_t b ){
+	constexpr uint32_t colorPrepare565( uint8_t r, uint8_t g, uint8_t b ){
 		return ((r & 0xF8) << 8) | ((g & 0xFC) << 19) | ((b & 0xF8) >> 3);
 	}
 
@@ -646,10 +693,10 @@ namespace mac{
 	 * Calculate the pre-multiplied value of alpha for fast blending. Converts to range 0-31
 	 * @param alpha  	Alpha value 0-255
 	 */
-	inline uint8_t alpha5bit( uint8_t a ){
+	constexpr uint8_t alpha5bit( uint8_t a ){
 		return a >> 3;
 	}
-	inline uint8_t alpha5bit( alpha a ){
+	constexpr uint8_t alpha5bit( alpha a ){
 		return (uint8_t)( alphaClamp(a) * 31 );
 	}
 
@@ -705,6 +752,63 @@ namespace mac{
 		return (color565)((result >> 16) | result); // contract result
 	}
 
+	/**
+	 * Add two RGB565 colors (additive blending, for glows and light). Each channel saturates
+	 * at full brightness. The channels are added in one go in the expanded 32-bit layout, and
+	 * the carry out of each channel is turned into a saturation mask, so there are no
+	 * per-channel branches.
+	 * @param	fg		Color to add in RGB565 (16bit)
+	 * @param	bg		Color to add to in RGB565 (16bit)
+	 * @return 			The sum
+	 **/
+	inline color565 blendAdd565(
+		uint32_t fg,
+		uint32_t bg
+	){
+		bg = (bg | (bg << 16)) & 0b00000111111000001111100000011111;
+		fg = (fg | (fg << 16)) & 0b00000111111000001111100000011111;
+		uint32_t result = fg + bg;
+		uint32_t carry = result & 0b00001000000000010000000000100000; // bit above each channel
+		carry -= ((carry & 0b00000000000000010000000000100000) >> 5) | (carry >> 6 & 0b00000000001000000000000000000000);
+		result = (result | carry) & 0b00000111111000001111100000011111;
+		return (color565)((result >> 16) | result); // contract result
+	}
+
+	/**
+	 * Multiply two RGB565 colors (for shadows and color filters). White leaves the other
+	 * color unchanged and black gives black.
+	 * @param	fg		Color to multiply by in RGB565 (16bit)
+	 * @param	bg		Color to multiply in RGB565 (16bit)
+	 * @return 			The product
+	 **/
+	inline color565 blendMultiply565(
+		uint32_t fg,
+		uint32_t bg
+	){
+		// x / 31 (or 63) is exact as (x + (x >> 5) + 1) >> 5 for products of two channels
+		uint32_t r = (fg >> 11) * (bg >> 11);
+		uint32_t g = ((fg >> 5) & 0x3F) * ((bg >> 5) & 0x3F);
+		uint32_t b = (fg & 0x1F) * (bg & 0x1F);
+		r = (r + (r >> 5) + 1) >> 5;
+		g = (g + (g >> 6) + 1) >> 6;
+		b = (b + (b >> 5) + 1) >> 5;
+		return (color565)((r << 11) | (g << 5) | b);
+	}
+
+	/**
+	 * Screen two RGB565 colors (a softer, non-saturating lighten). This is the inverse of
+	 * multiplying the inverse colors.
+	 * @param	fg		Color to screen with in RGB565 (16bit)
+	 * @param	bg		Color to screen in RGB565 (16bit)
+	 * @return 			The result
+	 **/
+	inline color565 blendScreen565(
+		uint32_t fg,
+		uint32_t bg
+	){
+		return ~blendMultiply565( ~fg & 0xFFFF, ~bg & 0xFFFF );
+	}
+
 	/**
 	 *  #####    #####   #####
 	 *  ##  ##  ##       ##  ##
@@ -948,7 +1052,7 @@ namespace mac{
 	 * @param	b		Blue component
 	 * @return		The RGB888 color
 	 **/
-	inline color888 convertRGBto888(
+	constexpr color888 convertRGBto888(
 		uint8_t r,
 		uint8_t g,
 		uint8_t b
@@ -961,7 +1065,7 @@ namespace mac{
 	 * @param	color	The RGB565 color to convert
 	 * @return		The RGB888 color
 	 **/
-	inline color888 convert565to888(
+	constexpr color888 convert565to888(
 		color565 c
 	){
 		return ((c & 0b1111100000000000) << 8) | ((c & 0b11100000000) << 3)
@@ -974,7 +1078,7 @@ namespace mac{
 	 * @param  c 	The grayscale value (0-255)
 	 * @return		The RGB888 color
 	 */
-	inline color888 convert8to888( uint8_t c ){
+	constexpr color888 convert8to888( uint8_t c ){
 		return (c << 16) | (c << 8) | c;
 	}
 
@@ -983,7 +1087,7 @@ namespace mac{
 	 * @param  c 	The mono value (0-1)
 	 * @return		The RGB888 color
 	 */
-	inline color888 convert1to888( uint8_t c ){
+	constexpr color888 convert1to888( uint8_t c ){
 		return (c & 0b1)?RGB888_White:RGB888_Black;
 	}
 
@@ -1020,7 +1124,7 @@ namespace mac{
 	 * @param  a  	The alpha 0.0 - 1.0
 	 * @return   The 8-bit alpha value
 	 */
-	inline uint8_t alpha8bit( alpha a ){
+	constexpr uint8_t alpha8bit( alpha a ){
 		return (uint8_t)( alphaClamp(a) * 255 );
 	}
 
@@ -1050,6 +1154,24 @@ namespace mac{
 		og  = g << 8;
 	}
 
+	/**
+	 * The two split components of a color prepared for 888 fast blending
+	 **/
+	typedef struct Prepared888S {
+		uint32_t rb;						// RB split component
+		uint32_t g;							// G split component
+	} Prepared888;
+
+	/**
+	 * Calculate the split components of a 24-bit RGB color for 888 fast blending. Unlike
+	 * colorPrepare888 the components are returned, so this can be done at compile time.
+	 * @param  c 	RGB888 color
+	 * @return   	The split components (@see alphaBlendPrepared8888)
+	 */
+	constexpr Prepared888 colorPrepared888( color888 c ){
+		return { c & 0xff00ff, c & 0x00ff00 };
+	}
+
 	/**
 	 * Blend two RGB888 pixels
 	 * @param	fg		Color to draw in RGB 8-bit (24 bit)
@@ -1087,7 +1209,125 @@ namespace mac{
 		preparedG  += ((bg & 0x00ff00) -  preparedG) * alpha >> 8;
 		return (preparedRB & 0xff00ff) | (preparedG & 0xff00);
 	}
+
+	/**
+	 * Add two RGB888 colors (additive blending), saturating each channel at 255. All three
+	 * channels are added at once: the top bit of each byte is added separately so no carry
+	 * crosses into the next channel, and each carry out becomes a 0xFF mask. The top byte
+	 * (alpha) of the result is that of bg.
+	 * @param	fg		Color to add in RGB 8-bit (24 bit)
+	 * @param	bg		Color to add to (alpha is kept)
+	 * @return       	The sum
+	 */
+	inline color8888 blendAdd8888(
+		color8888 fg,
+		color8888 bg
+	){
+		uint32_t a = fg & 0xffffff;
+		uint32_t b = bg & 0xffffff;
+		uint32_t sum = ((a & 0x7f7f7f) + (b & 0x7f7f7f));
+		uint32_t carry = ((a & b) | ((a | b) & sum)) & 0x808080; // carry out of each byte
+		sum ^= (a ^ b) & 0x808080;
+		return (bg & 0xff000000) | sum | ((carry >> 7) * 0xff);
+	}
+
+	/**
+	 * Multiply two RGB888 colors. White leaves the other color unchanged and black gives black.
+	 * The top byte (alpha) of the result is that of bg.
+	 * @param	fg		Color to multiply by in RGB 8-bit (24 bit)
+	 * @param	bg		Color to multiply (alpha is kept)
+	 * @return       	The product
+	 */
+	inline color8888 blendMultiply8888(
+		color8888 fg,
+		color8888 bg
+	){
+		// x / 255 is exact as (x + (x >> 8) + 1) >> 8 for products of two channels
+		uint32_t r = ((fg >> 16) & 0xff) * ((bg >> 16) & 0xff);
+		uint32_t g = ((fg >> 8) & 0xff) * ((bg >> 8) & 0xff);
+		uint32_t b = (fg & 0xff) * (bg & 0xff);
+		r = (r + (r >> 8) + 1) >> 8;
+		g = (g + (g >> 8) + 1) >> 8;
+		b = (b + (b >> 8) + 1) >> 8;
+		return (bg & 0xff000000) | (r << 16) | (g << 8) | b;
+	}
+
+	/**
+	 * Screen two RGB888 colors (a softer, non-saturating lighten). The top byte (alpha) of the
+	 * result is that of bg.
+	 * @param	fg		Color to screen with in RGB 8-bit (24 bit)
+	 * @param	bg		Color to screen (alpha is kept)
+	 * @return       	The result
+	 */
+	inline color8888 blendScreen8888(
+		color8888 fg,
+		color8888 bg
+	){
+		return (bg & 0xff000000) | (~blendMultiply8888( ~fg, ~bg ) & 0xffffff);
+	}
 	
+
+	/*
+	 * ### COMPILE-TIME COLORS
+	 *
+	 * The conversions above are constexpr, so named colors can be converted to any pixel
+	 * format at compile time and used in static tables and switch cases:
+	 *     const color4444 warning = color<PF_4444>( RGB888_Orange );
+	 *     const uint32_t prepared = colorPrepare565( color<PF_565>( RGB888_White ) );
+	 *     const Prepared888 glow = colorPrepared888( RGB888_Gold );
+	 **/
+
+	/**
+	 * The type of a single color in each pixel format
+	 **/
+	template<PixelFormat PF> struct PixelFormatColor { typedef uint32_t type; };
+	template<> struct PixelFormatColor<PF_565> { typedef color565 type; };
+	template<> struct PixelFormatColor<PF_4444> { typedef color4444 type; };
+	template<> struct PixelFormatColor<PF_6666> { typedef color6666 type; };
+	template<> struct PixelFormatColor<PF_8565> { typedef color8565 type; };
+	template<> struct PixelFormatColor<PF_888> { typedef color888 type; };
+	template<> struct PixelFormatColor<PF_8888> { typedef color8888 type; };
+	template<> struct PixelFormatColor<PF_GRAYSCALE> { typedef colorGray type; };
+	template<> struct PixelFormatColor<PF_MONO> { typedef uint8_t type; };
+
+	/**
+	 * Convert RGB888 to 8-bit grayscale, with the same weights as the image loader
+	 * @param  c 	The RGB888 color
+	 * @return   	The gray level (0-255)
+	 */
+	constexpr colorGray convert888to8( color888 c ){
+		return (((c >> 16) & 0xFF) * 77 + ((c >> 8) & 0xFF) * 150 + (c & 0xFF) * 29) >> 8;
+	}
+
+	/**
+	 * Convert RGB888 to an opaque color in any pixel format, packed the same way as the
+	 * tilemap data (alpha in the top bits)
+	 * @param  pf 	The pixel format (not PF_INDEXED)
+	 * @param  c 	The RGB888 color
+	 * @return   	The packed color, or 0 for PF_INDEXED and PF_UNKNOWN
+	 */
+	constexpr uint32_t convert888toFormat( PixelFormat pf, color888 c ){
+		return (pf == PF_565) ? convert888to565( c )
+			: (pf == PF_4444) ? (0xF000 | ((c >> 12) & 0x0F00) | ((c >> 8) & 0x00F0) | ((c >> 4) & 0x000F))
+			: (pf == PF_6666) ? (0xFC0000 | ((c >> 6) & 0x3F000) | ((c >> 4) & 0x00FC0) | ((c >> 2) & 0x0003F))
+			: (pf == PF_8565) ? (0xFF0000 | convert888to565( c ))
+			: (pf == PF_888) ? (c & 0xFFFFFF)
+			: (pf == PF_8888) ? (0xFF000000 | c)
+			: (pf == PF_GRAYSCALE) ? convert888to8( c )
+			: (pf == PF_MONO) ? (convert888to8( c ) >> 7)
+			: 0;
+	}
+
+	/**
+	 * Convert a RGB888 color (such as RGB888_Red) to a pixel format at compile time
+	 * @param  c 	The RGB888 color
+	 * @return   	The color in the type of the pixel format (@see PixelFormatColor)
+	 */
+	template<PixelFormat PF> constexpr typename PixelFormatColor<PF>::type color( color888 c ){
+		static_assert( (PF != PF_UNKNOWN) && (PF != PF_INDEXED), "color<>() needs a pixel format with direct color" );
+		return (typename PixelFormatColor<PF>::type)convert888toFormat( PF, c );
+	}
+
 } // ns
 
 #endif
\ No newline at end of file
@@ -0,0 +1,139 @@
+/**
+ * GUI library for "mac/μac"
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ **/
+
+#include "Blend.h"
+#include "RenderStats.h"
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * Fade a RGB888 color towards black. Alpha is 0-256 (256 leaves the color unchanged).
+	 */
+	static inline color8888 scale8888( color8888 c, uint32_t a ){
+		return (((c & 0xff00ff) * a >> 8) & 0xff00ff) | (((c & 0x00ff00) * a >> 8) & 0x00ff00);
+	}
+
+	/**
+	 * Blend a span of RGB565 pixels into a span of RGB565 pixels
+	 */
+	void blendSpan565(
+		const color565* src,
+		color565* dst,
+		uint16_t count,
+		BlendMode mode,
+		uint8_t amount
+	){
+		color565* end = dst + count;
+		uint8_t a = alpha5bit( amount );
+		if (!amount) return;
+		MAC_STAT_ADD( blended, count );
+		switch (mode){
+			case mac::BM_NORMAL:
+				if (amount == 255) memcpy( dst, src, count * sizeof(color565) );
+				else while (dst < end){
+					*dst = alphaBlend5565( *src++, *dst, a );
+					dst++;
+				}
+				break;
+			case mac::BM_ADD:
+				if (amount == 255) while (dst < end){
+					*dst = blendAdd565( *src++, *dst );
+					dst++;
+				}
+				else while (dst < end){
+					*dst = blendAdd565( alphaBlend5565( *src++, 0, a ), *dst );
+					dst++;
+				}
+				break;
+			case mac::BM_MULTIPLY:
+				if (amount == 255) while (dst < end){
+					*dst = blendMultiply565( *src++, *dst );
+					dst++;
+				}
+				else while (dst < end){
+					*dst = blendMultiply565( alphaBlend5565( *src++, 0xFFFF, a ), *dst );
+					dst++;
+				}
+				break;
+			case mac::BM_SCREEN:
+				if (amount == 255) while (dst < end){
+					*dst = blendScreen565( *src++, *dst );
+					dst++;
+				}
+				else while (dst < end){
+					*dst = blendScreen565( alphaBlend5565( *src++, 0, a ), *dst );
+					dst++;
+				}
+				break;
+		}
+	}
+
+	/**
+	 * Blend a span of ARGB8888 pixels into a span of ARGB8888 pixels
+	 */
+	void blendSpan8888(
+		const color8888* src,
+		color8888* dst,
+		uint16_t count,
+		BlendMode mode,
+		uint8_t amount
+	){
+		color8888* end = dst + count;
+		uint32_t s, a;
+		if (!amount) return;
+		MAC_STAT_ADD( blended, count );
+		switch (mode){
+			case mac::BM_NORMAL:
+				while (dst < end){
+					s = *src++;
+					a = ((s >> 24) * (amount + 1)) >> 8;
+					a += a >> 7;
+					uint32_t rb = *dst & 0xff00ff;
+					uint32_t g = *dst & 0x00ff00;
+					rb += ((s & 0xff00ff) - rb) * a >> 8;
+					g += ((s & 0x00ff00) - g) * a >> 8;
+					*dst = (*dst & 0xff000000) | (rb & 0xff00ff) | (g & 0xff00);
+					dst++;
+				}
+				break;
+			case mac::BM_ADD:
+				while (dst < end){
+					s = *src++;
+					a = ((s >> 24) * (amount + 1)) >> 8;
+					a += a >> 7;
+					*dst = blendAdd8888( scale8888( s, a ), *dst );
+					dst++;
+				}
+				break;
+			case mac::BM_MULTIPLY:
+				while (dst < end){
+					s = *src++;
+					a = ((s >> 24) * (amount + 1)) >> 8;
+					a += a >> 7;
+					*dst = blendMultiply8888( ~scale8888( ~s, a ), *dst );
+					dst++;
+				}
+				break;
+			case mac::BM_SCREEN:
+				while (dst < end){
+					s = *src++;
+					a = ((s >> 24) * (amount + 1)) >> 8;
+					a += a >> 7;
+					*dst = blendScreen8888( scale8888( s, a ), *dst );
+					dst++;
+				}
+				break;
+		}
+	}
+
+} // ns
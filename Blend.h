@@ -0,0 +1,92 @@
+/**
+ * Blend modes (normal, additive, multiply, screen) as span kernels
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ *
+ * MIT LICENCE
+ * -----------
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef _MAC_BLENDH_
+#define _MAC_BLENDH_ 1
+
+#include "Bitmap.h"
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * Blend modes
+	 **/
+	typedef enum {
+		BM_NORMAL			= 0,	// Source over destination (alpha blend)
+		BM_ADD				= 1,	// Add the source to the destination, saturating (glows, light, particles)
+		BM_MULTIPLY			= 2,	// Multiply the destination by the source (shadows, color filters)
+		BM_SCREEN			= 3		// Inverse multiply of the inverses (soft lighten)
+	} BlendMode;
+
+	/**
+	 * Blend a span of RGB565 pixels into a span of RGB565 pixels. Each mode has its own
+	 * loop using the packed kernels (blendAdd565, blendMultiply565, blendScreen565).
+	 * @param src 		The source pixels
+	 * @param dst 		The destination pixels
+	 * @param count 	Number of pixels
+	 * @param mode 		The blend mode
+	 * @param amount 	Strength of the source, 0-255. Below 255 the source is faded first:
+	 *               	towards black for normal, add and screen, and towards white for multiply.
+	 */
+	void blendSpan565(
+		const color565* src,
+		color565* dst,
+		uint16_t count,
+		BlendMode mode,
+		uint8_t amount = 255
+	);
+
+	/**
+	 * Blend a span of ARGB8888 pixels into a span of ARGB8888 pixels. The source alpha
+	 * (multiplied by amount) sets the strength of each source pixel, as in blendSpan565.
+	 * The alpha of the destination is kept.
+	 * @param src 		The source pixels
+	 * @param dst 		The destination pixels
+	 * @param count 	Number of pixels
+	 * @param mode 		The blend mode
+	 * @param amount 	Strength of the source, 0-255
+	 */
+	void blendSpan8888(
+		const color8888* src,
+		color8888* dst,
+		uint16_t count,
+		BlendMode mode,
+		uint8_t amount = 255
+	);
+
+} // ns
+
+#endif
@@ -0,0 +1,702 @@
+/**
+ * GUI library for "mac/μac"
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ **/
+
+#include "Blit.h"
+#include "ColorRemap.h"
+#include "RenderStats.h"
+#include "Trace.h"
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * Intersect two rectangles
+	 */
+	boolean rectIntersect( const Rect& a, const Rect& b, Rect& out ){
+		int16_t x0 = max( a.x, b.x );
+		int16_t y0 = max( a.y, b.y );
+		int16_t x1 = min( a.x + a.w, b.x + b.w );
+		int16_t y1 = min( a.y + a.h, b.y + b.h );
+		if ((x1 <= x0) || (y1 <= y0)){
+			out = { x0, y0, 0, 0 };
+			return false;
+		}
+		out = { x0, y0, (int16_t)(x1 - x0), (int16_t)(y1 - y0) };
+		return true;
+	}
+
+	/**
+	 * Get the smallest rectangle that holds two rectangles
+	 */
+	void rectUnion( const Rect& a, const Rect& b, Rect& out ){
+		if ((b.w <= 0) || (b.h <= 0)){
+			out = a;
+			return;
+		}
+		if ((a.w <= 0) || (a.h <= 0)){
+			out = b;
+			return;
+		}
+		int16_t x0 = min( a.x, b.x );
+		int16_t y0 = min( a.y, b.y );
+		int16_t x1 = max( a.x + a.w, b.x + b.w );
+		int16_t y1 = max( a.y + a.h, b.y + b.h );
+		out = { x0, y0, (int16_t)(x1 - x0), (int16_t)(y1 - y0) };
+	}
+
+	/**
+	 * Pixel counts of one span. These are kept in locals and added to the render stats once
+	 * per span (MAC_STAT_SPAN), so the per-pixel code does not touch the stats.
+	 */
+	typedef struct SpanCountsS {
+		uint32_t copied;
+		uint32_t blended;
+		uint32_t skipped;
+	} SpanCounts;
+
+	#define MAC_STAT_SPAN(n) do{ MAC_STAT_ADD( copied, (n).copied ); MAC_STAT_ADD( blended, (n).blended ); MAC_STAT_ADD( skipped, (n).skipped ); }while(0)
+
+	/**
+	 * Blend a RGB565 color with 8-bit alpha over a destination pixel. Fully transparent
+	 * pixels are skipped and fully opaque pixels are copied, so the common cases do not
+	 * pay for the blend.
+	 */
+	static inline void blendPixel8565( color565* dst, color565 c, uint8_t a, SpanCounts& n ){
+		if (a == 255){
+			*dst = c;
+			n.copied++;
+		}
+		else if (a){
+			*dst = alphaBlend8565( c, *dst, a );
+			n.blended++;
+		}
+		else n.skipped++;
+	}
+
+	/**
+	 * Copy a pixel unless it is the color key
+	 */
+	static inline void keyPixel565( color565* dst, color565 c, boolean transparent, SpanCounts& n ){
+		if (transparent) n.skipped++;
+		else{
+			*dst = c;
+			n.copied++;
+		}
+	}
+
+	/**
+	 * Apply the color effects (grayscale, then brightness, then tint) to a RGB565 color
+	 */
+	static inline color565 effectColor565( color565 c, const BlitEffects& fx ){
+		uint32_t r = c >> 11;
+		uint32_t g = (c >> 5) & 0x3F;
+		uint32_t b = c & 0x1F;
+		if (fx.grayscale){
+			// Luma with weights 77, 150, 29 (out of 256), on channels expanded to 8 bits so
+			// that full scale stays full scale
+			uint32_t y = (((r << 3) | (r >> 2)) * 77 + ((g << 2) | (g >> 4)) * 150 + ((b << 3) | (b >> 2)) * 29) >> 8;
+			r = b = y >> 3;
+			g = y >> 2;
+		}
+		if (fx.brightness != 256){
+			r = min( (r * fx.brightness) >> 8, (uint32_t)31 );
+			g = min( (g * fx.brightness) >> 8, (uint32_t)63 );
+			b = min( (b * fx.brightness) >> 8, (uint32_t)31 );
+		}
+		c = (r << 11) | (g << 5) | b;
+		if (fx.tintAmount == 255) c = fx.tint;
+		else if (fx.tintAmount) c = alphaBlend8565( fx.tint, c, fx.tintAmount );
+		return c;
+	}
+
+	/**
+	 * Draw a horizontal span of source pixels over a row of RGB565 pixels. Which of the remap,
+	 * color effects and opacity are applied is decided at compile time, so the plain span pays
+	 * nothing for them.
+	 */
+	template<boolean REMAP, boolean COLOR, boolean OPACITY>
+	static void blitSpan(
+		const uint8_t* src,
+		PixelFormat pixelFormat,
+		uint32_t transparentColor,
+		color565* dst,
+		uint16_t count,
+		const ColorRemap* remap,
+		const BlitEffects* fx
+	){
+		color565* end = dst + count;
+		uint16_t c;
+		uint8_t a;
+		uint16_t opacity = OPACITY ? fx->opacity + 1 : 256;
+		SpanCounts n = { 0, 0, 0 };
+		switch (pixelFormat){
+			case mac::PF_565:
+				while (dst < end){
+					c = (src[0] << 8) | src[1];
+					boolean transparent = c == transparentColor;
+					if (REMAP && !transparent) c = colorRemapLookup( *remap, c );
+					if (COLOR && !transparent) c = effectColor565( c, *fx );
+					if (OPACITY) blendPixel8565( dst, c, transparent ? 0 : fx->opacity, n );
+					else keyPixel565( dst, c, transparent, n );
+					src += 2; dst++;
+				}
+				break;
+			case mac::PF_888:
+				while (dst < end){
+					uint32_t c888 = (src[0] << 16) | (src[1] << 8) | src[2];
+					boolean transparent = c888 == transparentColor;
+					c = convert888to565( c888 );
+					if (REMAP && !transparent) c = colorRemapLookup( *remap, c );
+					if (COLOR && !transparent) c = effectColor565( c, *fx );
+					if (OPACITY) blendPixel8565( dst, c, transparent ? 0 : fx->opacity, n );
+					else keyPixel565( dst, c, transparent, n );
+					src += 3; dst++;
+				}
+				break;
+			case mac::PF_4444:
+				while (dst < end){
+					get4444as8565( (uint8_t*)src, c, a );
+					if (REMAP && a) c = colorRemapLookup( *remap, c );
+					if (COLOR && a) c = effectColor565( c, *fx );
+					if (OPACITY) a = (a * opacity) >> 8;
+					blendPixel8565( dst, c, a, n );
+					src += 2; dst++;
+				}
+				break;
+			case mac::PF_6666:
+				while (dst < end){
+					get6666as8565( (uint8_t*)src, c, a );
+					if (REMAP && a) c = colorRemapLookup( *remap, c );
+					if (COLOR && a) c = effectColor565( c, *fx );
+					if (OPACITY) a = (a * opacity) >> 8;
+					blendPixel8565( dst, c, a, n );
+					src += 3; dst++;
+				}
+				break;
+			case mac::PF_8565:
+				while (dst < end){
+					c = (src[1] << 8) | src[2];
+					a = src[0];
+					if (REMAP && a) c = colorRemapLookup( *remap, c );
+					if (COLOR && a) c = effectColor565( c, *fx );
+					if (OPACITY) a = (a * opacity) >> 8;
+					blendPixel8565( dst, c, a, n );
+					src += 3; dst++;
+				}
+				break;
+			case mac::PF_8888:
+				while (dst < end){
+					c = ((src[1] & 0xF8) << 8) | ((src[2] & 0xFC) << 3) | (src[3] >> 3);
+					a = src[0];
+					if (REMAP && a) c = colorRemapLookup( *remap, c );
+					if (COLOR && a) c = effectColor565( c, *fx );
+					if (OPACITY) a = (a * opacity) >> 8;
+					blendPixel8565( dst, c, a, n );
+					src += 4; dst++;
+				}
+				break;
+			case mac::PF_GRAYSCALE:
+				if (OPACITY){
+					while (dst < end){
+						c = convert8to565( *src++ );
+						if (REMAP) c = colorRemapLookup( *remap, c );
+						if (COLOR) c = effectColor565( c, *fx );
+						blendPixel8565( dst++, c, fx->opacity, n );
+					}
+					break;
+				}
+				while (dst < end){
+					c = convert8to565( *src++ );
+					if (REMAP) c = colorRemapLookup( *remap, c );
+					if (COLOR) c = effectColor565( c, *fx );
+					*dst++ = c;
+				}
+				n.copied += count;
+				break;
+			default:
+				// XXX: Handle mono and indexed colors
+				break;
+		}
+		MAC_STAT_SPAN( n );
+	}
+
+	/**
+	 * Draw a horizontal span of source pixels over a row of RGB565 pixels
+	 */
+	void blitSpan565(
+		const uint8_t* src,
+		PixelFormat pixelFormat,
+		uint32_t transparentColor,
+		color565* dst,
+		uint16_t count,
+		const ColorRemap* remap,
+		const BlitEffects* fx
+	){
+		uint8_t mode = 0;
+		if (remap && remap->count) mode |= 4;
+		if (fx){
+			if (!fx->opacity){
+				MAC_STAT_ADD( skipped, count );
+				return;
+			}
+			if (fx->grayscale || (fx->brightness != 256) || fx->tintAmount) mode |= 2;
+			if (fx->opacity != 255) mode |= 1;
+		}
+		MAC_STAT_CONVERTED( pixelFormat, count );
+		switch (mode){
+			case 0: blitSpan<false, false, false>( src, pixelFormat, transparentColor, dst, count, remap, fx ); break;
+			case 1: blitSpan<false, false, true>( src, pixelFormat, transparentColor, dst, count, remap, fx ); break;
+			case 2: blitSpan<false, true, false>( src, pixelFormat, transparentColor, dst, count, remap, fx ); break;
+			case 3: blitSpan<false, true, true>( src, pixelFormat, transparentColor, dst, count, remap, fx ); break;
+			case 4: blitSpan<true, false, false>( src, pixelFormat, transparentColor, dst, count, remap, fx ); break;
+			case 5: blitSpan<true, false, true>( src, pixelFormat, transparentColor, dst, count, remap, fx ); break;
+			case 6: blitSpan<true, true, false>( src, pixelFormat, transparentColor, dst, count, remap, fx ); break;
+			case 7: blitSpan<true, true, true>( src, pixelFormat, transparentColor, dst, count, remap, fx ); break;
+		}
+	}
+
+	/**
+	 * Reset blit effects to none
+	 */
+	void blitEffectsReset( BlitEffects& fx ){
+		fx.opacity = 255;
+		fx.brightness = 256;
+		fx.tint = 0;
+		fx.tintAmount = 0;
+		fx.grayscale = false;
+	}
+
+	/**
+	 * Get a view of a rectangle of another view
+	 */
+	BitmapView subView( const BitmapView& view, const Rect& rect ){
+		BitmapView sub = view;
+		Rect area;
+		if (!rectIntersect( { 0, 0, (int16_t)view.width, (int16_t)view.height }, rect, area )){
+			sub.width = sub.height = 0;
+			return sub;
+		}
+		uint8_t bpp = (view.native && (view.pixelFormat == mac::PF_8888)) ? 4 : pixelFormatByteWidth( view.pixelFormat );
+		sub.data += area.y * view.stride + area.x * bpp;
+		sub.width = area.w;
+		sub.height = area.h;
+		return sub;
+	}
+
+	/**
+	 * Fill a rectangle of native RGB565 or ARGB8888 pixels
+	 */
+	static void fillRows( uint8_t* data, uint32_t stride, boolean is8888, const Rect& area, color8888 color ){
+		uint8_t* row = data + area.y * stride + area.x * (is8888 ? 4 : 2);
+		for (int16_t y = 0; y < area.h; y++){
+			if (is8888){
+				color8888* p = (color8888*)row;
+				for (int16_t x = 0; x < area.w; x++) p[x] = color;
+			}
+			else{
+				color565* p = (color565*)row;
+				for (int16_t x = 0; x < area.w; x++) p[x] = (color565)color;
+			}
+			row += stride;
+		}
+	}
+
+	/**
+	 * Fill a rectangle of the framebuffer with a solid color
+	 */
+	void fillRect565( Framebuffer& fb, const Rect& rect, color565 color ){
+		MAC_STAT_TIMER( RS_FILL );
+		MAC_TRACE_BLIT_SCOPE( "fill" );
+		Rect area;
+		if (!rectIntersect( framebufferRect( fb ), rect, area )) return;
+		fillRows( (uint8_t*)fb.data, fb.width * 2, false, area, color );
+	}
+
+	/**
+	 * Fill a rectangle of a native RGB565 or ARGB8888 view with a solid color
+	 */
+	boolean fillView( BitmapView& view, const Rect& rect, color8888 color ){
+		MAC_STAT_TIMER( RS_FILL );
+		MAC_TRACE_BLIT_SCOPE( "fill" );
+		Rect area;
+		if (!rectIntersect( { 0, 0, (int16_t)view.width, (int16_t)view.height }, rect, area )) return false;
+		if (!view.native && (view.pixelFormat == mac::PF_8565)){
+			color565 c = convert888to565( color );
+			uint8_t* row = view.data + area.y * view.stride + area.x * 3;
+			for (int16_t y = 0; y < area.h; y++){
+				uint8_t* p = row;
+				for (int16_t x = 0; x < area.w; x++){
+					*p++ = color >> 24;
+					*p++ = c >> 8;
+					*p++ = c;
+				}
+				row += view.stride;
+			}
+			return true;
+		}
+		if (!view.native) return false;
+		switch (view.pixelFormat){
+			case mac::PF_565: fillRows( view.data, view.stride, false, area, convert888to565( color ) ); return true;
+			case mac::PF_8888: fillRows( view.data, view.stride, true, area, color ); return true;
+			default: return false;
+		}
+	}
+
+	/**
+	 * Draw a span of native RGB565 or ARGB8888 pixels over a row of RGB565 pixels. These come
+	 * from buffers in RAM (usually render targets), so the effects are not specialised.
+	 */
+	static void nativeSpan565(
+		const uint8_t* src,
+		PixelFormat pixelFormat,
+		uint32_t transparentColor,
+		color565* dst,
+		uint16_t count,
+		const ColorRemap* remap,
+		const BlitEffects* fx
+	){
+		color565* end = dst + count;
+		boolean doRemap = remap && remap->count;
+		boolean color = fx && (fx->grayscale || (fx->brightness != 256) || fx->tintAmount);
+		uint16_t opacity = fx ? fx->opacity + 1 : 256;
+		SpanCounts n = { 0, 0, 0 };
+		MAC_STAT_CONVERTED( pixelFormat, count );
+		if (pixelFormat == mac::PF_8888){
+			const color8888* p = (const color8888*)src;
+			while (dst < end){
+				color565 c = convert888to565( *p );
+				uint8_t a = *p >> 24;
+				if (a){
+					if (doRemap) c = colorRemapLookup( *remap, c );
+					if (color) c = effectColor565( c, *fx );
+					a = (a * opacity) >> 8;
+				}
+				blendPixel8565( dst, c, a, n );
+				p++; dst++;
+			}
+		}
+		else if (!doRemap && !fx){
+			const color565* p = (const color565*)src;
+			while (dst < end){
+				keyPixel565( dst, *p, *p == transparentColor, n );
+				p++; dst++;
+			}
+		}
+		else{
+			const color565* p = (const color565*)src;
+			while (dst < end){
+				color565 c = *p;
+				if (c != transparentColor){
+					if (doRemap) c = colorRemapLookup( *remap, c );
+					if (color) c = effectColor565( c, *fx );
+					blendPixel8565( dst, c, (255 * opacity) >> 8, n );
+				}
+				else n.skipped++;
+				p++; dst++;
+			}
+		}
+		MAC_STAT_SPAN( n );
+	}
+
+	/**
+	 * Draw a view into a native RGB565 view
+	 */
+	boolean drawView565(
+		BitmapView& dst,
+		const BitmapView& src,
+		int16_t x,
+		int16_t y,
+		const Rect* clip,
+		const ColorRemap* remap,
+		const BlitEffects* fx
+	){
+		MAC_STAT_TIMER( RS_BLIT );
+		MAC_TRACE_BLIT_SCOPE( "blit" );
+		if (!dst.native || (dst.pixelFormat != mac::PF_565)) return false;
+		Rect area = { 0, 0, (int16_t)dst.width, (int16_t)dst.height };
+		Rect dest = { x, y, (int16_t)src.width, (int16_t)src.height };
+		if ((clip && !rectIntersect( area, *clip, area )) || !rectIntersect( area, dest, area )){
+			MAC_STAT_ADD( tilesCulled, 1 );
+			return false;
+		}
+		MAC_STAT_ADD( tilesDrawn, 1 );
+
+		uint8_t bpp = (src.native && (src.pixelFormat == mac::PF_8888)) ? 4 : pixelFormatByteWidth( src.pixelFormat );
+		const uint8_t* s = src.data + (area.y - y) * src.stride + (area.x - x) * bpp;
+		uint8_t* d = dst.data + area.y * dst.stride + area.x * 2;
+		for (int16_t row = 0; row < area.h; row++){
+			if (src.native) nativeSpan565( s, src.pixelFormat, src.transparentColor, (color565*)d, area.w, remap, fx );
+			else blitSpan565( s, src.pixelFormat, src.transparentColor, (color565*)d, area.w, remap, fx );
+			s += src.stride;
+			d += dst.stride;
+		}
+		return true;
+	}
+
+	/**
+	 * Expand a RGB565 color to RGB888, repeating the top bits of each channel in the new low
+	 * bits so that white stays white
+	 */
+	static inline color888 expand565to888( color565 c ){
+		uint32_t r = c >> 11;
+		uint32_t g = (c >> 5) & 0x3F;
+		uint32_t b = c & 0x1F;
+		return (((r << 3) | (r >> 2)) << 16) | (((g << 2) | (g >> 4)) << 8) | ((b << 3) | (b >> 2));
+	}
+
+	/**
+	 * Read one pixel of any format as ARGB8888. Color keyed pixels have zero alpha.
+	 */
+	static color8888 readPixel8888( const uint8_t* p, PixelFormat pixelFormat, uint32_t transparentColor, boolean native ){
+		uint32_t c;
+		color565 c565;
+		uint8_t a;
+		if (native){
+			if (pixelFormat == mac::PF_8888) return *(const color8888*)p;
+			c565 = *(const color565*)p;
+			return ((c565 == transparentColor) ? 0 : 0xFF000000) | expand565to888( c565 );
+		}
+		switch (pixelFormat){
+			case mac::PF_565:
+				c = (p[0] << 8) | p[1];
+				return ((c == transparentColor) ? 0 : 0xFF000000) | expand565to888( c );
+			case mac::PF_888:
+				c = (p[0] << 16) | (p[1] << 8) | p[2];
+				return ((c == transparentColor) ? 0 : 0xFF000000) | c;
+			case mac::PF_4444:
+				get4444as8565( (uint8_t*)p, c565, a );
+				return ((uint32_t)a << 24) | expand565to888( c565 );
+			case mac::PF_6666:
+				get6666as8565( (uint8_t*)p, c565, a );
+				return ((uint32_t)a << 24) | expand565to888( c565 );
+			case mac::PF_8565:
+				return ((uint32_t)p[0] << 24) | expand565to888( (p[1] << 8) | p[2] );
+			case mac::PF_8888:
+				return ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+			case mac::PF_GRAYSCALE:
+				return 0xFF000000 | (p[0] << 16) | (p[0] << 8) | p[0];
+			default:
+				return 0;
+		}
+	}
+
+	/**
+	 * Composite an ARGB8888 color over another (neither is premultiplied)
+	 */
+	static inline color8888 over8888( color8888 s, color8888 d ){
+		uint32_t sa = s >> 24;
+		uint32_t da = d >> 24;
+		if ((sa == 255) || !da) return s;
+		if (!sa) return d;
+		if (da == 255){
+			// Opaque destination: a plain blend
+			sa += sa >> 7;
+			uint32_t rb = d & 0xff00ff;
+			uint32_t g = d & 0x00ff00;
+			rb += ((s & 0xff00ff) - rb) * sa >> 8;
+			g += ((s & 0x00ff00) - g) * sa >> 8;
+			return 0xff000000 | (rb & 0xff00ff) | (g & 0xff00);
+		}
+		// Both partly transparent: weight the destination by what shows through the source
+		uint32_t dw = (da * (255 - sa) + 127) / 255;
+		uint32_t oa = sa + dw;
+		uint32_t r = (((s >> 16) & 0xff) * sa + ((d >> 16) & 0xff) * dw) / oa;
+		uint32_t g = (((s >> 8) & 0xff) * sa + ((d >> 8) & 0xff) * dw) / oa;
+		uint32_t b = ((s & 0xff) * sa + (d & 0xff) * dw) / oa;
+		return (oa << 24) | (r << 16) | (g << 8) | b;
+	}
+
+	/**
+	 * Draw a view into any view that can be a destination
+	 */
+	boolean drawView(
+		BitmapView& dst,
+		const BitmapView& src,
+		int16_t x,
+		int16_t y,
+		const Rect* clip
+	){
+		if (dst.native && (dst.pixelFormat == mac::PF_565)) return drawView565( dst, src, x, y, clip );
+		boolean is8888 = dst.native && (dst.pixelFormat == mac::PF_8888);
+		if (!is8888 && (dst.native || (dst.pixelFormat != mac::PF_8565))) return false;
+
+		MAC_STAT_TIMER( RS_BLIT );
+		MAC_TRACE_BLIT_SCOPE( "blit" );
+		Rect area = { 0, 0, (int16_t)dst.width, (int16_t)dst.height };
+		Rect dest = { x, y, (int16_t)src.width, (int16_t)src.height };
+		if ((clip && !rectIntersect( area, *clip, area )) || !rectIntersect( area, dest, area )){
+			MAC_STAT_ADD( tilesCulled, 1 );
+			return false;
+		}
+		MAC_STAT_ADD( tilesDrawn, 1 );
+		MAC_STAT_CONVERTED( src.pixelFormat, area.w * area.h );
+
+		uint8_t sbpp = (src.native && (src.pixelFormat == mac::PF_8888)) ? 4 : pixelFormatByteWidth( src.pixelFormat );
+		uint8_t dbpp = is8888 ? 4 : 3;
+		const uint8_t* srow = src.data + (area.y - y) * src.stride + (area.x - x) * sbpp;
+		uint8_t* drow = dst.data + area.y * dst.stride + area.x * dbpp;
+		uint32_t skipped = 0;
+		for (int16_t row = 0; row < area.h; row++){
+			const uint8_t* s = srow;
+			uint8_t* d = drow;
+			for (int16_t col = 0; col < area.w; col++){
+				color8888 c = readPixel8888( s, src.pixelFormat, src.transparentColor, src.native );
+				if (!(c >> 24)) skipped++;
+				else if (is8888) *(color8888*)d = over8888( c, *(color8888*)d );
+				else{
+					c = over8888( c, readPixel8888( d, mac::PF_8565, 0, false ) );
+					color565 c565 = convert888to565( c );
+					d[0] = c >> 24;
+					d[1] = c565 >> 8;
+					d[2] = c565;
+				}
+				s += sbpp;
+				d += dbpp;
+			}
+			srow += src.stride;
+			drow += dst.stride;
+		}
+		MAC_STAT_ADD( skipped, skipped );
+		return true;
+	}
+
+	/**
+	 * Convert the pixels of a view into a native RGB565 or ARGB8888 view
+	 */
+	boolean convertView( BitmapView& dst, const BitmapView& src ){
+		if (!dst.native || ((dst.pixelFormat != mac::PF_565) && (dst.pixelFormat != mac::PF_8888))) return false;
+		uint16_t w = min( dst.width, src.width );
+		uint16_t h = min( dst.height, src.height );
+		uint8_t bpp = (src.native && (src.pixelFormat == mac::PF_8888)) ? 4 : pixelFormatByteWidth( src.pixelFormat );
+		MAC_STAT_CONVERTED( src.pixelFormat, w * h );
+		for (uint16_t y = 0; y < h; y++){
+			const uint8_t* s = src.data + y * src.stride;
+			uint8_t* d = dst.data + y * dst.stride;
+			for (uint16_t x = 0; x < w; x++){
+				color8888 c = readPixel8888( s, src.pixelFormat, src.transparentColor, src.native );
+				if (dst.pixelFormat == mac::PF_8888) ((color8888*)d)[x] = (c >> 24) ? c : 0;
+				else ((color565*)d)[x] = (c >> 24) ? convert888to565( c ) : (color565)dst.transparentColor;
+				s += bpp;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * Draw a rectangle of source pixels into the framebuffer
+	 */
+	boolean drawPixels565(
+		Framebuffer& fb,
+		const uint8_t* data,
+		PixelFormat pixelFormat,
+		uint32_t transparentColor,
+		uint32_t rowStride,
+		uint16_t w,
+		uint16_t h,
+		int16_t x,
+		int16_t y,
+		const Rect* clip,
+		const ColorRemap* remap,
+		const BlitEffects* fx
+	){
+		BitmapView dst = framebufferView( fb );
+		BitmapView src = { (uint8_t*)data, w, h, rowStride, pixelFormat, transparentColor, false };
+		return drawView565( dst, src, x, y, clip, remap, fx );
+	}
+
+	/**
+	 * Draw a single tile from a tilemap into the framebuffer
+	 */
+	boolean drawTile565(
+		Framebuffer& fb,
+		const Tilemap& tilemap,
+		uint32_t index,
+		int16_t x,
+		int16_t y,
+		const Rect* clip,
+		const ColorRemap* remap,
+		const BlitEffects* fx
+	){
+		if (index >= tilemap.tileCount) return false;
+		return drawPixels565(
+			fb,
+			tilemap.data + tilemap.tileStride * index,
+			tilemap.pixelFormat,
+			tilemap.transparentColor,
+			tilemap.tileWidth * pixelFormatByteWidth( tilemap.pixelFormat ),
+			tilemap.tileWidth, tilemap.tileHeight,
+			x, y,
+			clip,
+			remap,
+			fx
+		);
+	}
+
+	/**
+	 * Draw a sprite from an atlas into the framebuffer
+	 */
+	boolean drawAtlas565(
+		Framebuffer& fb,
+		const Atlas& atlas,
+		uint32_t index,
+		int16_t x,
+		int16_t y,
+		const Rect* clip,
+		const ColorRemap* remap,
+		const BlitEffects* fx
+	){
+		if (index >= atlas.count) return false;
+		const AtlasRect& r = atlas.rects[index];
+		if (!r.w || !r.h) return false;
+		uint8_t bpp = pixelFormatByteWidth( atlas.bitmap.pixelFormat );
+		uint32_t rowStride = atlas.bitmap.width * bpp;
+		return drawPixels565(
+			fb,
+			atlas.bitmap.data + r.y * rowStride + r.x * bpp,
+			atlas.bitmap.pixelFormat,
+			atlas.bitmap.transparentColor,
+			rowStride,
+			r.w, r.h,
+			x + r.offsetX, y + r.offsetY,
+			clip,
+			remap,
+			fx
+		);
+	}
+
+	/**
+	 * Draw a bitmap into the framebuffer
+	 */
+	boolean drawBitmap565(
+		Framebuffer& fb,
+		const Bitmap& bitmap,
+		int16_t x,
+		int16_t y,
+		const Rect* clip,
+		const ColorRemap* remap,
+		const BlitEffects* fx
+	){
+		return drawPixels565(
+			fb,
+			bitmap.data,
+			bitmap.pixelFormat,
+			bitmap.transparentColor,
+			bitmap.width * pixelFormatByteWidth( bitmap.pixelFormat ),
+			bitmap.width, bitmap.height,
+			x, y,
+			clip,
+			remap,
+			fx
+		);
+	}
+
+} // ns
@@ -0,0 +1,415 @@
+/**
+ * Drawing tiles and bitmaps into a RGB565 framebuffer
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ *
+ * MIT LICENCE
+ * -----------
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef _MAC_BLITH_
+#define _MAC_BLITH_ 1
+
+#include "Bitmap.h"
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * A rectangle in framebuffer (pixel) coordinates
+	 **/
+	typedef struct RectS {
+		int16_t x;							// Left edge
+		int16_t y;							// Top edge
+		int16_t w;							// Width in pixels
+		int16_t h;							// Height in pixels
+	} Rect;
+
+	/**
+	 * Intersect two rectangles
+	 * @param  a 		The first rectangle
+	 * @param  b 		The second rectangle
+	 * @param  out 		(out) The intersection. May be the same as a or b.
+	 * @return   		True if the rectangles overlap, otherwise false (out is then empty)
+	 */
+	boolean rectIntersect( const Rect& a, const Rect& b, Rect& out );
+
+	/**
+	 * Check whether two rectangles overlap
+	 * @param  a 		The first rectangle
+	 * @param  b 		The second rectangle
+	 * @return   		True if the rectangles share at least one pixel
+	 */
+	inline boolean rectOverlaps( const Rect& a, const Rect& b ){
+		return (a.x < b.x + b.w) && (b.x < a.x + a.w) && (a.y < b.y + b.h) && (b.y < a.y + a.h);
+	}
+
+	/**
+	 * Get the smallest rectangle that holds two rectangles. Empty rectangles are ignored.
+	 * @param  a 		The first rectangle
+	 * @param  b 		The second rectangle
+	 * @param  out 		(out) The union. May be the same as a or b.
+	 */
+	void rectUnion( const Rect& a, const Rect& b, Rect& out );
+
+	/**
+	 * A table of color replacements (see ColorRemap.h)
+	 **/
+	typedef struct ColorRemapS ColorRemap;
+
+	/**
+	 * A RGB565 framebuffer in RAM that tiles and bitmaps are drawn into.
+	 * Pixels are stored as native color565 values, row by row.
+	 **/
+	typedef struct FramebufferS {
+		color565* data;						// Pixel data (width x height)
+		uint16_t width;						// Width of the framebuffer in pixels
+		uint16_t height;					// Height of the framebuffer in pixels
+	} Framebuffer;
+
+	/**
+	 * Get the full area of a framebuffer as a rectangle
+	 * @param  fb 		The framebuffer
+	 * @return    		The rectangle 0,0,width,height
+	 */
+	inline Rect framebufferRect( const Framebuffer& fb ){
+		return { 0, 0, (int16_t)fb.width, (int16_t)fb.height };
+	}
+
+	/*
+	 * ### VIEWS
+	 */
+
+	/**
+	 * A view of a rectangle of pixels inside a larger image or buffer, without copying it.
+	 * Views of converted assets (bitmaps, tiles, atlas sprites) hold big-endian bytes, as
+	 * written by tilemap_to_h.py, and are only used as a source. Views of buffers in RAM
+	 * (framebuffers and ARGB8888 buffers) are marked native: each pixel is a native color565
+	 * or color8888 value. These can be used as a source or a destination. The one exception is
+	 * ARGB8565, which has no native type: an ARGB8565 buffer in RAM (see RenderTarget.h) is
+	 * stored like an asset and can also be a destination.
+	 **/
+	typedef struct BitmapViewS {
+		uint8_t* data;						// Pointer to the top-left pixel
+		uint16_t width;						// Width in pixels
+		uint16_t height;					// Height in pixels
+		uint32_t stride;					// Number of bytes from one row to the next
+		PixelFormat pixelFormat;			// The format of each pixel
+		uint32_t transparentColor;			// For formats without alpha, the color key (in the source format)
+		boolean native;						// True if pixels are native color565 or color8888 values in RAM
+	} BitmapView;
+
+	/**
+	 * Get a view of a whole framebuffer
+	 * @param  fb 		The framebuffer
+	 * @return    		A native RGB565 view
+	 */
+	inline BitmapView framebufferView( Framebuffer& fb ){
+		return { (uint8_t*)fb.data, fb.width, fb.height, (uint32_t)fb.width * 2, PF_565, RGB565_Transparent, true };
+	}
+
+	/**
+	 * Get a view of a whole ARGB8888 buffer in RAM
+	 * @param  pixels 	The pixels, row by row
+	 * @param  width 	Width in pixels
+	 * @param  height 	Height in pixels
+	 * @return    		A native ARGB8888 view
+	 */
+	inline BitmapView bufferView8888( color8888* pixels, uint16_t width, uint16_t height ){
+		return { (uint8_t*)pixels, width, height, (uint32_t)width * 4, PF_8888, 0, true };
+	}
+
+	/**
+	 * Get a view of a whole bitmap
+	 * @param  bitmap 	The bitmap
+	 * @return    		A source view
+	 */
+	inline BitmapView bitmapView( const Bitmap& bitmap ){
+		return {
+			(uint8_t*)bitmap.data, (uint16_t)bitmap.width, (uint16_t)bitmap.height,
+			bitmap.width * pixelFormatByteWidth( bitmap.pixelFormat ),
+			bitmap.pixelFormat, bitmap.transparentColor, false
+		};
+	}
+
+	/**
+	 * Get a view of one tile of a tilemap
+	 * @param  tilemap 	The tilemap
+	 * @param  index 	The index of the tile (must be less than tileCount)
+	 * @return    		A source view
+	 */
+	inline BitmapView tileView( const Tilemap& tilemap, uint32_t index ){
+		return {
+			(uint8_t*)tilemap.data + tilemap.tileStride * index, (uint16_t)tilemap.tileWidth, (uint16_t)tilemap.tileHeight,
+			tilemap.tileWidth * pixelFormatByteWidth( tilemap.pixelFormat ),
+			tilemap.pixelFormat, tilemap.transparentColor, false
+		};
+	}
+
+	/**
+	 * Get a view of a rectangle of another view. No pixels are copied.
+	 * @param  view 	The view
+	 * @param  rect 	The rectangle, relative to the view (clipped to the view)
+	 * @return      	The view of the rectangle. Empty if the rectangle is outside the view.
+	 */
+	BitmapView subView( const BitmapView& view, const Rect& rect );
+
+
+	/*
+	 * ### EFFECTS
+	 */
+
+	/**
+	 * Color effects applied while blitting, in the same loop that converts and blends each
+	 * pixel. The color effects are applied in order: grayscale, brightness, then tint.
+	 * Use blitEffectsReset to start from no effects.
+	 **/
+	typedef struct BlitEffectsS {
+		uint8_t opacity;					// Global opacity, multiplied with per-pixel alpha (255 is opaque)
+		uint16_t brightness;				// Brightness scale out of 256 (256 is unchanged, 512 is double)
+		color565 tint;						// Tint color
+		uint8_t tintAmount;					// Amount of tint color to mix in (0 is none, 255 is all tint)
+		boolean grayscale;					// Convert to grayscale
+	} BlitEffects;
+
+	/**
+	 * Reset blit effects to none (opaque, unchanged brightness, no tint, full color)
+	 * @param fx 		The effects to reset
+	 */
+	void blitEffectsReset( BlitEffects& fx );
+
+	/*
+	 * ### SPANS
+	 */
+
+	/**
+	 * Draw a horizontal span of source pixels over a row of RGB565 pixels. The source pixels
+	 * are converted and alpha-blended in a single loop that is specialised for each pixel format,
+	 * so there is no per-pixel accessor call. Pixel formats without alpha treat transparentColor
+	 * as fully transparent. PF_MONO and PF_INDEXED are not supported and draw nothing.
+	 * If a color remap is given, each source color is replaced (after conversion to RGB565 and
+	 * before blending) in the same loop. The color key is checked before the remap. Effects
+	 * are applied after the remap. The inner loop is specialised for each combination of remap,
+	 * color effects and opacity, so spans without them run the same loop as before.
+	 * @param src 				Pointer to the first source pixel
+	 * @param pixelFormat 		The format of the source pixels
+	 * @param transparentColor 	For formats without alpha, the color key (in the source format)
+	 * @param dst 				Pointer to the first destination pixel
+	 * @param count 			Number of pixels in the span
+	 * @param remap 			Optional color remap
+	 * @param fx 				Optional color effects
+	 */
+	void blitSpan565(
+		const uint8_t* src,
+		PixelFormat pixelFormat,
+		uint32_t transparentColor,
+		color565* dst,
+		uint16_t count,
+		const ColorRemap* remap = 0,
+		const BlitEffects* fx = 0
+	);
+
+	/*
+	 * ### DRAWING
+	 */
+
+	/**
+	 * Fill a rectangle of the framebuffer with a solid color
+	 * @param fb 		The framebuffer to draw into
+	 * @param rect 		The rectangle to fill (clipped to the framebuffer)
+	 * @param color 	The fill color
+	 */
+	void fillRect565( Framebuffer& fb, const Rect& rect, color565 color );
+
+	/**
+	 * Fill a rectangle of a native RGB565, native ARGB8888 or ARGB8565 view with a solid color.
+	 * The pixels are replaced, not blended.
+	 * @param view 		The view to draw into
+	 * @param rect 		The rectangle to fill, relative to the view (clipped to the view)
+	 * @param color 	The fill color as ARGB8888 (converted to the format of the view)
+	 * @return 			False if the view can not be drawn into, or nothing was filled
+	 */
+	boolean fillView( BitmapView& view, const Rect& rect, color8888 color );
+
+	/**
+	 * Draw a view into a native RGB565 view. This is the common path used by tiles, bitmaps
+	 * and framebuffers. The source can be any converted asset format, or a native RGB565
+	 * (color keyed) or ARGB8888 view.
+	 * @param dst 		The native RGB565 view to draw into
+	 * @param src 		The view to draw
+	 * @param x 		Destination x position, relative to dst
+	 * @param y 		Destination y position, relative to dst
+	 * @param clip 		Optional clip rectangle, relative to dst
+	 * @param remap 	Optional color remap
+	 * @param fx 		Optional color effects
+	 * @return 			False if nothing was drawn (entirely clipped, or dst is not native RGB565)
+	 */
+	boolean drawView565(
+		BitmapView& dst,
+		const BitmapView& src,
+		int16_t x,
+		int16_t y,
+		const Rect* clip = 0,
+		const ColorRemap* remap = 0,
+		const BlitEffects* fx = 0
+	);
+
+	/**
+	 * Draw a view into any view that can be a destination: native RGB565 (see drawView565),
+	 * native ARGB8888 or ARGB8565. Destinations with alpha are composited with the source
+	 * over the destination, so the result is still correct when drawn over something else.
+	 * @param dst 		The view to draw into
+	 * @param src 		The view to draw
+	 * @param x 		Destination x position, relative to dst
+	 * @param y 		Destination y position, relative to dst
+	 * @param clip 		Optional clip rectangle, relative to dst
+	 * @return 			False if nothing was drawn (entirely clipped, or dst can not be drawn into)
+	 */
+	boolean drawView(
+		BitmapView& dst,
+		const BitmapView& src,
+		int16_t x,
+		int16_t y,
+		const Rect* clip = 0
+	);
+
+	/**
+	 * Convert the pixels of a view into a native RGB565 or ARGB8888 view, without blending.
+	 * Transparent pixels (color key, or zero alpha) become the transparent color of a RGB565
+	 * destination, or 0 (transparent black) in an ARGB8888 destination. If the views
+	 * are different sizes, only the top-left area that is in both is converted.
+	 * @param dst 		The native view to write into
+	 * @param src 		The view to convert
+	 * @return 			False if dst is not a native RGB565 or ARGB8888 view
+	 */
+	boolean convertView( BitmapView& dst, const BitmapView& src );
+
+	/**
+	 * Draw a rectangle of source pixels into the framebuffer. This is the common path used
+	 * by tiles and bitmaps.
+	 * @param fb 				The framebuffer to draw into
+	 * @param data 				Pointer to the first (top-left) source pixel
+	 * @param pixelFormat 		The format of the source pixels
+	 * @param transparentColor 	For formats without alpha, the color key (in the source format)
+	 * @param rowStride 		Number of bytes from one source row to the next
+	 * @param w 				Width of the source pixels
+	 * @param h 				Height of the source pixels
+	 * @param x 				Destination x position of the top-left pixel
+	 * @param y 				Destination y position of the top-left pixel
+	 * @param clip 				Optional clip rectangle (in addition to the framebuffer bounds)
+	 * @param remap 			Optional color remap
+	 * @param fx 				Optional color effects
+	 * @return 					False if nothing was drawn (entirely clipped)
+	 */
+	boolean drawPixels565(
+		Framebuffer& fb,
+		const uint8_t* data,
+		PixelFormat pixelFormat,
+		uint32_t transparentColor,
+		uint32_t rowStride,
+		uint16_t w,
+		uint16_t h,
+		int16_t x,
+		int16_t y,
+		const Rect* clip = 0,
+		const ColorRemap* remap = 0,
+		const BlitEffects* fx = 0
+	);
+
+	/**
+	 * Draw a single tile from a tilemap into the framebuffer
+	 * @param fb 		The framebuffer to draw into
+	 * @param tilemap 	The tilemap
+	 * @param index 	The index of the tile
+	 * @param x 		Destination x position of the tile
+	 * @param y 		Destination y position of the tile
+	 * @param clip 		Optional clip rectangle (in addition to the framebuffer bounds)
+	 * @param remap 	Optional color remap
+	 * @param fx 		Optional color effects
+	 * @return 			False if nothing was drawn (entirely clipped or no such tile)
+	 */
+	boolean drawTile565(
+		Framebuffer& fb,
+		const Tilemap& tilemap,
+		uint32_t index,
+		int16_t x,
+		int16_t y,
+		const Rect* clip = 0,
+		const ColorRemap* remap = 0,
+		const BlitEffects* fx = 0
+	);
+
+	/**
+	 * Draw a sprite from an atlas into the framebuffer. Only the trimmed pixels are processed,
+	 * placed where they were in the original cell.
+	 * @param fb 		The framebuffer to draw into
+	 * @param atlas 	The atlas
+	 * @param index 	The index of the sprite
+	 * @param x 		Destination x position of the (untrimmed) sprite cell
+	 * @param y 		Destination y position of the (untrimmed) sprite cell
+	 * @param clip 		Optional clip rectangle (in addition to the framebuffer bounds)
+	 * @param remap 	Optional color remap
+	 * @param fx 		Optional color effects
+	 * @return 			False if nothing was drawn (entirely clipped, empty, or no such sprite)
+	 */
+	boolean drawAtlas565(
+		Framebuffer& fb,
+		const Atlas& atlas,
+		uint32_t index,
+		int16_t x,
+		int16_t y,
+		const Rect* clip = 0,
+		const ColorRemap* remap = 0,
+		const BlitEffects* fx = 0
+	);
+
+	/**
+	 * Draw a bitmap into the framebuffer
+	 * @param fb 		The framebuffer to draw into
+	 * @param bitmap 	The bitmap
+	 * @param x 		Destination x position of the bitmap
+	 * @param y 		Destination y position of the bitmap
+	 * @param clip 		Optional clip rectangle (in addition to the framebuffer bounds)
+	 * @param remap 	Optional color remap
+	 * @param fx 		Optional color effects
+	 * @return 			False if nothing was drawn (entirely clipped)
+	 */
+	boolean drawBitmap565(
+		Framebuffer& fb,
+		const Bitmap& bitmap,
+		int16_t x,
+		int16_t y,
+		const Rect* clip = 0,
+		const ColorRemap* remap = 0,
+		const BlitEffects* fx = 0
+	);
+
+} // ns
+
+#endif
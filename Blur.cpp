@@ -0,0 +1,189 @@
+/**
+ * GUI library for "mac/μac"
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ **/
+
+#include "Blur.h"
+#include "RenderStats.h"
+#include "Trace.h"
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * Box blur one line of RGB565 pixels. Red and blue share one running sum (16 bits each)
+	 * and green has its own. The division by the box width is a multiply and shift.
+	 * @param in 		The original pixels of the line
+	 * @param out 		Where to write the blurred line
+	 * @param step 		Distance between output pixels (1 for a row, the stride for a column)
+	 * @param count 	Number of pixels in the line
+	 * @param r 		Radius
+	 */
+	static void blurLine565( const color565* in, color565* out, uint32_t step, int32_t count, int32_t r ){
+		uint32_t inv = (65536 + 2 * r) / (2 * r + 1); // rounded up, so a flat color stays the same
+		int32_t last = count - 1;
+		uint32_t rb = 0, g = 0, c;
+
+		// Prime the box around the first pixel, repeating the edge
+		for (int32_t i = -r; i <= r; i++){
+			c = in[ min( max( i, (int32_t)0 ), last ) ];
+			rb += ((c & 0xF800) << 5) | (c & 0x1F);
+			g += c & 0x07E0;
+		}
+		for (int32_t x = 0; x < count; x++){
+			*out = (((((rb >> 16) * inv) >> 16) << 11)) | ((((g >> 5) * inv) >> 16) << 5) | (((rb & 0xFFFF) * inv) >> 16);
+			out += step;
+			c = in[ min( x + r + 1, last ) ];
+			rb += ((c & 0xF800) << 5) | (c & 0x1F);
+			g += c & 0x07E0;
+			c = in[ max( x - r, (int32_t)0 ) ];
+			rb -= ((c & 0xF800) << 5) | (c & 0x1F);
+			g -= c & 0x07E0;
+		}
+	}
+
+	/**
+	 * Box blur one line of ARGB8888 pixels. Red and blue share one running sum, and alpha
+	 * and green another (16 bits per channel).
+	 */
+	static void blurLine8888( const color8888* in, color8888* out, uint32_t step, int32_t count, int32_t r ){
+		uint32_t inv = (65536 + 2 * r) / (2 * r + 1); // rounded up, so a flat color stays the same
+		int32_t last = count - 1;
+		uint32_t rb = 0, ag = 0, c;
+		for (int32_t i = -r; i <= r; i++){
+			c = in[ min( max( i, (int32_t)0 ), last ) ];
+			rb += c & 0x00FF00FF;
+			ag += (c >> 8) & 0x00FF00FF;
+		}
+		for (int32_t x = 0; x < count; x++){
+			*out = ((((ag >> 16) * inv) >> 16) << 24)
+				| ((((rb >> 16) * inv) >> 16) << 16)
+				| ((((ag & 0xFFFF) * inv) >> 16) << 8)
+				| (((rb & 0xFFFF) * inv) >> 16);
+			out += step;
+			c = in[ min( x + r + 1, last ) ];
+			rb += c & 0x00FF00FF;
+			ag += (c >> 8) & 0x00FF00FF;
+			c = in[ max( x - r, (int32_t)0 ) ];
+			rb -= c & 0x00FF00FF;
+			ag -= (c >> 8) & 0x00FF00FF;
+		}
+	}
+
+	/**
+	 * Clip the area to blur, and clamp the radius
+	 */
+	static boolean blurArea( uint16_t width, uint16_t height, uint8_t& radius, const Rect* area, Rect& out ){
+		out = { 0, 0, (int16_t)width, (int16_t)height };
+		if (area && !rectIntersect( out, *area, out )) return false;
+		if ((out.w > MAC_BLUR_MAX) || (out.h > MAC_BLUR_MAX) || !radius) return false;
+		radius = min( radius, (uint8_t)127 );
+		return true;
+	}
+
+	/**
+	 * Blur a native RGB565 or ARGB8888 view, or a rectangle of it, with a box blur
+	 */
+	boolean blurView( BitmapView& view, uint8_t radius, const Rect* area ){
+		MAC_STAT_TIMER( RS_BLUR );
+		MAC_TRACE_SCOPE( "blur" );
+		Rect a;
+		if (!view.native || !blurArea( view.width, view.height, radius, area, a )) return false;
+		if (view.pixelFormat == mac::PF_565){
+			color565 line[ MAC_BLUR_MAX ];
+			uint32_t step = view.stride / sizeof(color565);
+			color565* row = (color565*)(view.data + a.y * view.stride) + a.x;
+			for (int16_t y = 0; y < a.h; y++){
+				memcpy( line, row, a.w * sizeof(color565) );
+				blurLine565( line, row, 1, a.w, radius );
+				row += step;
+			}
+			color565* col = (color565*)(view.data + a.y * view.stride) + a.x;
+			for (int16_t x = 0; x < a.w; x++){
+				for (int16_t y = 0; y < a.h; y++) line[y] = col[y * step];
+				blurLine565( line, col, step, a.h, radius );
+				col++;
+			}
+			return true;
+		}
+		if (view.pixelFormat == mac::PF_8888){
+			color8888 line[ MAC_BLUR_MAX ];
+			uint32_t step = view.stride / sizeof(color8888);
+			color8888* row = (color8888*)(view.data + a.y * view.stride) + a.x;
+			for (int16_t y = 0; y < a.h; y++){
+				memcpy( line, row, a.w * sizeof(color8888) );
+				blurLine8888( line, row, 1, a.w, radius );
+				row += step;
+			}
+			color8888* col = (color8888*)(view.data + a.y * view.stride) + a.x;
+			for (int16_t x = 0; x < a.w; x++){
+				for (int16_t y = 0; y < a.h; y++) line[y] = col[y * step];
+				blurLine8888( line, col, step, a.h, radius );
+				col++;
+			}
+			return true;
+		}
+		return false;
+	}
+
+	/**
+	 * Blur a RGB565 framebuffer, or a rectangle of it, with a box blur
+	 */
+	boolean blur565( Framebuffer& fb, uint8_t radius, const Rect* area ){
+		BitmapView view = framebufferView( fb );
+		return blurView( view, radius, area );
+	}
+
+	/**
+	 * Blur an ARGB8888 buffer, or a rectangle of it, with a box blur
+	 */
+	boolean blur8888( color8888* pixels, uint16_t width, uint16_t height, uint8_t radius, const Rect* area ){
+		BitmapView view = bufferView8888( pixels, width, height );
+		return blurView( view, radius, area );
+	}
+
+	/**
+	 * Benchmark blurs of increasing radius
+	 */
+	uint8_t benchmarkBlur(
+		Framebuffer& fb,
+		color8888* buffer8888,
+		uint8_t minRadius,
+		uint8_t maxRadius,
+		uint16_t frames,
+		BlurBenchmark* results,
+		Print* out
+	){
+		if (!frames) frames = 1;
+		if (!minRadius) minRadius = 1;
+		if (out) out->print( "radius   us/565 blur   us/8888 blur\n" );
+		uint8_t count = 0;
+		char line[80];
+		for (uint16_t r = minRadius; r <= maxRadius; r++){
+			BlurBenchmark& b = results[count++];
+			b.radius = r;
+			uint32_t start = micros();
+			for (uint16_t f = 0; f < frames; f++) blur565( fb, r );
+			b.us565 = (float)(micros() - start) / frames;
+			b.us8888 = 0;
+			if (buffer8888){
+				start = micros();
+				for (uint16_t f = 0; f < frames; f++) blur8888( buffer8888, fb.width, fb.height, r );
+				b.us8888 = (float)(micros() - start) / frames;
+			}
+			if (out){
+				snprintf( line, sizeof(line), "%6u   %11.1f   %12.1f\n", r, b.us565, b.us8888 );
+				out->print( line );
+			}
+		}
+		return count;
+	}
+
+} // ns
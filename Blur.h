@@ -0,0 +1,119 @@
+/**
+ * Fast box blur for RGB565 and ARGB8888 buffers
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ *
+ * MIT LICENCE
+ * -----------
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef _MAC_BLURH_
+#define _MAC_BLURH_ 1
+
+#include "Blit.h"
+
+/**
+ * Largest width or height that can be blurred. A line of this many pixels is kept on the
+ * stack (4 bytes per pixel).
+ **/
+#ifndef MAC_BLUR_MAX
+	#define MAC_BLUR_MAX 512
+#endif
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * Blur a RGB565 framebuffer, or a rectangle of it, with a box blur. The blur is done
+	 * in place as a horizontal then a vertical pass. Each pass keeps a running sum of the
+	 * pixels under the box, so the cost per pixel is the same for any radius. Pixels outside
+	 * the rectangle are not read: the edge pixels are repeated instead. Blur twice for a
+	 * smoother (closer to gaussian) result.
+	 * @param  fb 		The framebuffer
+	 * @param  radius 	Radius of the box in pixels (1-127). The box is 2 x radius + 1 wide.
+	 * @param  area 	Optional rectangle to blur (clipped to the framebuffer)
+	 * @return 			False if nothing was blurred (empty area, or larger than MAC_BLUR_MAX)
+	 */
+	boolean blur565( Framebuffer& fb, uint8_t radius, const Rect* area = 0 );
+
+	/**
+	 * Blur an ARGB8888 buffer, or a rectangle of it, with a box blur. All four channels
+	 * are blurred. See blur565.
+	 * @param  pixels 	The pixels, row by row
+	 * @param  width 	Width of the buffer in pixels
+	 * @param  height 	Height of the buffer in pixels
+	 * @param  radius 	Radius of the box in pixels (1-127)
+	 * @param  area 	Optional rectangle to blur (clipped to the buffer)
+	 * @return 			False if nothing was blurred
+	 */
+	boolean blur8888( color8888* pixels, uint16_t width, uint16_t height, uint8_t radius, const Rect* area = 0 );
+
+	/**
+	 * Blur a native RGB565 or ARGB8888 view, or a rectangle of it, with a box blur. Use this
+	 * to blur a region of a shared buffer. See blur565.
+	 * @param  view 	The view
+	 * @param  radius 	Radius of the box in pixels (1-127)
+	 * @param  area 	Optional rectangle to blur, relative to the view (clipped to the view)
+	 * @return 			False if nothing was blurred (also if the view is not native RGB565 or ARGB8888)
+	 */
+	boolean blurView( BitmapView& view, uint8_t radius, const Rect* area = 0 );
+
+	/**
+	 * Result of one step of the blur benchmark
+	 **/
+	typedef struct BlurBenchmarkS {
+		uint8_t radius;						// Radius of the blur
+		float us565;						// Time to blur the RGB565 framebuffer, in microseconds
+		float us8888;						// Time to blur the ARGB8888 buffer, in microseconds (0 if none)
+	} BlurBenchmark;
+
+	/**
+	 * Benchmark blurs of increasing radius. The time should stay flat as the radius grows.
+	 * @param  fb 			The RGB565 framebuffer to blur
+	 * @param  buffer8888 	Optional ARGB8888 buffer the same size as fb, or 0 to skip 8888
+	 * @param  minRadius 	The first radius to time (for example 2)
+	 * @param  maxRadius 	The last radius to time (for example 16)
+	 * @param  frames 		The number of blurs to time at each radius
+	 * @param  results 		(out) One result per radius. Must have room for maxRadius - minRadius + 1.
+	 * @param  out 			Optional output to print a report to
+	 * @return 				The number of results written
+	 */
+	uint8_t benchmarkBlur(
+		Framebuffer& fb,
+		color8888* buffer8888,
+		uint8_t minRadius,
+		uint8_t maxRadius,
+		uint16_t frames,
+		BlurBenchmark* results,
+		Print* out = 0
+	);
+
+} // ns
+
+#endif
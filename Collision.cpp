@@ -0,0 +1,70 @@
+/**
+ * GUI library for "mac/μac"
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ **/
+
+#include "Collision.h"
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * Get 32 pixels of a mask row starting at any pixel, leftmost pixel in the top bit.
+	 * Pixels before or after the row are 0.
+	 */
+	static inline uint32_t maskBits( const uint32_t* row, int32_t rowWords, int32_t start ){
+		int32_t word = (start >= 0) ? (start >> 5) : -((31 - start) >> 5);
+		uint32_t shift = start & 31;
+		uint32_t hi = ((word >= 0) && (word < rowWords)) ? row[word] : 0;
+		if (!shift) return hi;
+		uint32_t lo = ((word + 1 >= 0) && (word + 1 < rowWords)) ? row[word + 1] : 0;
+		return (hi << shift) | (lo >> (32 - shift));
+	}
+
+	/**
+	 * Check whether two positioned masks overlap on at least one solid pixel
+	 */
+	boolean maskOverlap(
+		const HitMask& a, uint32_t indexA, int16_t ax, int16_t ay,
+		const HitMask& b, uint32_t indexB, int16_t bx, int16_t by
+	){
+		if ((indexA >= a.count) || (indexB >= b.count)) return false;
+
+		// Overlap of the two tiles, in the coordinates of the first
+		int32_t dx = bx - ax;
+		int32_t dy = by - ay;
+		int32_t x0 = max( (int32_t)0, dx );
+		int32_t y0 = max( (int32_t)0, dy );
+		int32_t x1 = min( (int32_t)a.width, dx + (int32_t)b.width );
+		int32_t y1 = min( (int32_t)a.height, dy + (int32_t)b.height );
+		if ((x1 <= x0) || (y1 <= y0)) return false;
+
+		// Step the words of the first mask that cover the overlap. The first and last
+		// words are trimmed so that pixels outside of the overlap are ignored.
+		int32_t w0 = x0 >> 5;
+		int32_t w1 = (x1 - 1) >> 5;
+		uint32_t firstBits = 0xFFFFFFFF >> (x0 & 31);
+		uint32_t lastBits = 0xFFFFFFFF << (31 - ((x1 - 1) & 31));
+		const uint32_t* rowA = a.data + indexA * a.stride + y0 * a.rowWords;
+		const uint32_t* rowB = b.data + indexB * b.stride + (y0 - dy) * b.rowWords;
+		for (int32_t y = y0; y < y1; y++){
+			for (int32_t w = w0; w <= w1; w++){
+				uint32_t bits = rowA[w];
+				if (w == w0) bits &= firstBits;
+				if (w == w1) bits &= lastBits;
+				if (bits & maskBits( rowB, b.rowWords, (w << 5) - dx )) return true;
+			}
+			rowA += a.rowWords;
+			rowB += b.rowWords;
+		}
+		return false;
+	}
+
+} // ns
@@ -0,0 +1,80 @@
+/**
+ * Pixel-perfect hit testing and collision using 1-bit masks
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ *
+ * MIT LICENCE
+ * -----------
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef _MAC_COLLISIONH_
+#define _MAC_COLLISIONH_ 1
+
+#include "Bitmap.h"
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * Check whether a pixel of a mask is solid. This reads a single bit, so it is cheap
+	 * enough for touch input on irregular icons.
+	 * @param mask 		The hit masks
+	 * @param index 	The index of the mask (tile)
+	 * @param x 		X position within the tile
+	 * @param y 		Y position within the tile
+	 * @return 			True if the pixel is solid. False if it is transparent or outside the tile.
+	 */
+	inline boolean hitTest( const HitMask& mask, uint32_t index, int16_t x, int16_t y ){
+		if ((index >= mask.count) || (x < 0) || (y < 0) || ((uint32_t)x >= mask.width) || ((uint32_t)y >= mask.height)) return false;
+		uint32_t word = mask.data[ index * mask.stride + y * mask.rowWords + (x >> 5) ];
+		return (word >> (31 - (x & 31))) & 1;
+	}
+
+	/**
+	 * Check whether two positioned masks overlap on at least one solid pixel. Only the rows
+	 * and words where the two tiles overlap are tested, 32 pixels at a time, by shifting the
+	 * second mask into line with the first and ANDing the words.
+	 * @param a 		The first hit masks
+	 * @param indexA 	The index of the first mask (tile)
+	 * @param ax 		X position of the first tile
+	 * @param ay 		Y position of the first tile
+	 * @param b 		The second hit masks (may be the same as the first)
+	 * @param indexB 	The index of the second mask (tile)
+	 * @param bx 		X position of the second tile
+	 * @param by 		Y position of the second tile
+	 * @return 			True if a solid pixel of one tile is over a solid pixel of the other
+	 */
+	boolean maskOverlap(
+		const HitMask& a, uint32_t indexA, int16_t ax, int16_t ay,
+		const HitMask& b, uint32_t indexB, int16_t bx, int16_t by
+	);
+
+} // ns
+
+#endif
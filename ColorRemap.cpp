@@ -0,0 +1,168 @@
+/**
+ * GUI library for "mac/μac"
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ **/
+
+#include "ColorRemap.h"
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * Initialise an empty color remap
+	 */
+	boolean colorRemapInit( ColorRemap& remap, uint32_t* entries, uint16_t size ){
+		if ((size < 2) || (size & (size - 1))) return false;
+		remap.entries = entries;
+		remap.mask = size - 1;
+		remap.shift = 32;
+		while (size > 1){
+			remap.shift--;
+			size >>= 1;
+		}
+		remap.count = 0;
+		for (uint32_t i = 0; i <= remap.mask; i++) remap.entries[i] = MAC_REMAP_EMPTY;
+		return true;
+	}
+
+	/**
+	 * Replace one color with another
+	 */
+	boolean colorRemapSet( ColorRemap& remap, color565 from, color565 to ){
+		uint16_t i = colorRemapHash( remap, from );
+		uint32_t e;
+		while ((e = remap.entries[i]) != MAC_REMAP_EMPTY){
+			if ((e >> 16) == from) break;
+			i = (i + 1) & remap.mask;
+		}
+
+		// Add or replace
+		if (from != to){
+			if (e == MAC_REMAP_EMPTY){
+				if ((uint32_t)(remap.count + 1) * 4 > (uint32_t)(remap.mask + 1) * 3) return false;
+				remap.count++;
+			}
+			remap.entries[i] = ((uint32_t)from << 16) | to;
+			return true;
+		}
+
+		// Remove. Later entries in the same run are moved back so that every entry can still
+		// be reached from its hash slot without a gap.
+		if (e == MAC_REMAP_EMPTY) return true;
+		remap.count--;
+		uint16_t j = i;
+		while (true){
+			j = (j + 1) & remap.mask;
+			if (remap.entries[j] == MAC_REMAP_EMPTY) break;
+			uint16_t home = colorRemapHash( remap, remap.entries[j] >> 16 );
+			// Move entry j into the gap at i unless its home slot is cyclically in (i, j]
+			boolean reachable = (i <= j) ? ((home > i) && (home <= j)) : ((home > i) || (home <= j));
+			if (!reachable){
+				remap.entries[i] = remap.entries[j];
+				i = j;
+			}
+		}
+		remap.entries[i] = MAC_REMAP_EMPTY;
+		return true;
+	}
+
+	/**
+	 * Collect the distinct colors of a tilemap, as RGB565 and in ascending order
+	 */
+	uint32_t tilemapColors565( const Tilemap& tilemap, color565* colors, uint32_t maxColors ){
+		uint8_t bpp = pixelFormatByteWidth( tilemap.pixelFormat );
+		if (!bpp) return 0;
+		uint32_t found = 0;
+		const uint8_t* end = tilemap.data + tilemap.tileStride * tilemap.tileCount;
+		for (const uint8_t* p = tilemap.data; p < end; p += bpp){
+			// Convert the same way as blitSpan565
+			color565 c;
+			uint8_t a = 255;
+			switch (tilemap.pixelFormat){
+				case mac::PF_565:
+					c = (p[0] << 8) | p[1];
+					if (c == tilemap.transparentColor) a = 0;
+					break;
+				case mac::PF_888:{
+					uint32_t c888 = (p[0] << 16) | (p[1] << 8) | p[2];
+					c = convert888to565( c888 );
+					if (c888 == tilemap.transparentColor) a = 0;
+					break;
+				}
+				case mac::PF_4444: get4444as8565( (uint8_t*)p, c, a ); break;
+				case mac::PF_6666: get6666as8565( (uint8_t*)p, c, a ); break;
+				case mac::PF_8565: c = (p[1] << 8) | p[2]; a = p[0]; break;
+				case mac::PF_8888:
+					c = ((p[1] & 0xF8) << 8) | ((p[2] & 0xFC) << 3) | (p[3] >> 3);
+					a = p[0];
+					break;
+				case mac::PF_GRAYSCALE: c = convert8to565( p[0] ); break;
+				default: return 0;
+			}
+			if (!a) continue;
+
+			// Insert into the sorted list
+			uint32_t lo = 0, hi = found;
+			while (lo < hi){
+				uint32_t mid = (lo + hi) >> 1;
+				if (colors[mid] < c) lo = mid + 1;
+				else hi = mid;
+			}
+			if ((lo < found) && (colors[lo] == c)) continue;
+			if (found == maxColors) return maxColors + 1;
+			memmove( colors + lo + 1, colors + lo, (found - lo) * sizeof(color565) );
+			colors[lo] = c;
+			found++;
+		}
+		return found;
+	}
+
+	/**
+	 * Draw every tile of a tilemap, side by side, until the framebuffer is covered
+	 */
+	static uint32_t timeTiles( Framebuffer& fb, const Tilemap& tilemap, const ColorRemap* remap, uint16_t frames ){
+		uint32_t start = micros();
+		for (uint16_t f = 0; f < frames; f++){
+			uint32_t index = 0;
+			for (int32_t y = 0; y < fb.height; y += tilemap.tileHeight){
+				for (int32_t x = 0; x < fb.width; x += tilemap.tileWidth){
+					drawTile565( fb, tilemap, index, x, y, 0, remap );
+					if (++index == tilemap.tileCount) index = 0;
+				}
+			}
+		}
+		return micros() - start;
+	}
+
+	/**
+	 * Benchmark the remapping blit against the plain blit
+	 */
+	ColorRemapBenchmark benchmarkColorRemap(
+		Framebuffer& fb,
+		const Tilemap& tilemap,
+		const ColorRemap& remap,
+		uint16_t frames,
+		Print* out
+	){
+		ColorRemapBenchmark r;
+		if (!frames) frames = 1;
+		timeTiles( fb, tilemap, 0, 1 ); // warm up
+		r.usPlain = (float)timeTiles( fb, tilemap, 0, frames ) / frames;
+		r.usRemapped = (float)timeTiles( fb, tilemap, &remap, frames ) / frames;
+		r.overhead = (r.usPlain > 0) ? r.usRemapped / r.usPlain : 0;
+		if (out){
+			char line[80];
+			snprintf( line, sizeof(line), "plain %.1f us/frame, remapped %.1f us/frame (%.2fx, %u colors)\n", r.usPlain, r.usRemapped, r.overhead, remap.count );
+			out->print( line );
+		}
+		return r;
+	}
+
+} // ns
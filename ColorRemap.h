@@ -0,0 +1,148 @@
+/**
+ * Runtime color remapping (palette swaps) for direct-color tiles and bitmaps
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ *
+ * MIT LICENCE
+ * -----------
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef _MAC_COLORREMAPH_
+#define _MAC_COLORREMAPH_ 1
+
+#include "Blit.h"
+
+/**
+ * Value of an unused entry in a color remap table. An entry that maps 0xFFFF to itself
+ * would have the same value, but colors that map to themselves are never stored.
+ **/
+#define MAC_REMAP_EMPTY 0xFFFFFFFF
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * A table of RGB565 to RGB565 color replacements, used to draw the same art in a
+	 * different color scheme. It is an open-addressed hash table. Each entry holds the
+	 * source color in the top 16 bits and the replacement in the bottom 16 bits. Colors
+	 * that are not in the table are drawn unchanged. The table memory is supplied by the
+	 * caller, so a remap can be static or live in flash once built.
+	 **/
+	typedef struct ColorRemapS {
+		uint32_t* entries;					// Hash table entries (size is a power of 2)
+		uint16_t mask;						// Size of the table - 1
+		uint8_t shift;						// 32 - log2(size), used to hash a color
+		uint16_t count;						// Number of colors in the table
+	} ColorRemap;
+
+	/**
+	 * Get the first table slot for a color
+	 */
+	inline uint16_t colorRemapHash( const ColorRemap& remap, color565 c ){
+		return (uint16_t)(((uint32_t)c * 2654435761u) >> remap.shift);
+	}
+
+	/**
+	 * Initialise an empty color remap
+	 * @param remap 	The color remap
+	 * @param entries 	Memory for the table
+	 * @param size 		Number of entries. Must be a power of 2 (2 to 32768). A table can be up
+	 *              	to 3/4 full, so allow 4 entries for every 3 colors.
+	 * @return 			False if the size is not a power of 2
+	 */
+	boolean colorRemapInit( ColorRemap& remap, uint32_t* entries, uint16_t size );
+
+	/**
+	 * Replace one color with another. Setting a color to itself removes it from the table.
+	 * @param remap 	The color remap
+	 * @param from 		The source color
+	 * @param to 		The color to draw instead
+	 * @return 			False if the table is full
+	 */
+	boolean colorRemapSet( ColorRemap& remap, color565 from, color565 to );
+
+	/**
+	 * Get the replacement for a color. This is called for every pixel by the remapping blit,
+	 * so it is inline and usually takes a single probe.
+	 * @param remap 	The color remap
+	 * @param c 		The source color
+	 * @return 			The replacement color, or c if it is not remapped
+	 */
+	inline color565 colorRemapLookup( const ColorRemap& remap, color565 c ){
+		uint16_t i = colorRemapHash( remap, c );
+		uint32_t e;
+		while ((e = remap.entries[i]) != MAC_REMAP_EMPTY){
+			if ((e >> 16) == c) return (color565)e;
+			i = (i + 1) & remap.mask;
+		}
+		return c;
+	}
+
+	/**
+	 * Collect the distinct colors of a tilemap, as RGB565 and in ascending order. Use this to
+	 * build a color scheme: map each color to its replacement with colorRemapSet. Pixels with
+	 * no alpha (or that match the transparent color) are not collected.
+	 * @param  tilemap 		The tilemap
+	 * @param  colors 		(out) The distinct colors
+	 * @param  maxColors 	Room in colors
+	 * @return         		The number of distinct colors, or maxColors + 1 if there were more
+	 *                  	colors than would fit
+	 */
+	uint32_t tilemapColors565( const Tilemap& tilemap, color565* colors, uint32_t maxColors );
+
+	/**
+	 * Result of the color remap benchmark
+	 **/
+	typedef struct ColorRemapBenchmarkS {
+		float usPlain;						// Average time to draw a frame without a remap, in microseconds
+		float usRemapped;					// Average time to draw a frame with the remap, in microseconds
+		float overhead;						// usRemapped / usPlain
+	} ColorRemapBenchmark;
+
+	/**
+	 * Benchmark the remapping blit against the plain blit. Each frame draws every tile of the
+	 * tilemap, side by side, until the framebuffer is covered.
+	 * @param  fb 			The framebuffer to draw into
+	 * @param  tilemap 		The tilemap
+	 * @param  remap 		The color remap
+	 * @param  frames 		The number of frames to draw each way
+	 * @param  out 			Optional output to print a report to
+	 * @return 				The timings
+	 */
+	ColorRemapBenchmark benchmarkColorRemap(
+		Framebuffer& fb,
+		const Tilemap& tilemap,
+		const ColorRemap& remap,
+		uint16_t frames,
+		Print* out = 0
+	);
+
+} // ns
+
+#endif
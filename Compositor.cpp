@@ -0,0 +1,210 @@
+/**
+ * GUI library for "mac/μac"
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ **/
+
+#include "Compositor.h"
+#include "RenderStats.h"
+#include "Trace.h"
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * Accumulated color and remaining transparency of the pixels in a span. Colors are kept
+	 * as RGB565 channels weighted by coverage (0-255).
+	 */
+	typedef struct SpanAccS {
+		uint16_t t[MAC_COMPOSITOR_SPAN];	// How much of what is behind still shows (255 = all, 0 = opaque)
+		uint16_t r[MAC_COMPOSITOR_SPAN];
+		uint16_t g[MAC_COMPOSITOR_SPAN];
+		uint16_t b[MAC_COMPOSITOR_SPAN];
+		uint16_t open;						// Pixels that are not yet opaque
+		OverdrawStats* stats;
+	} SpanAcc;
+
+	/**
+	 * Divide by 255, exact for 0 - 65534 (inputs here are at most 255 * 255)
+	 */
+	static inline uint16_t div255( uint32_t x ){
+		return (x + 1 + (x >> 8)) >> 8;
+	}
+
+	/**
+	 * Add a pixel behind what has already been resolved at position i of the span
+	 */
+	static inline void under( SpanAcc& s, uint16_t i, color565 c, uint8_t a ){
+		if (!a) return;
+		uint16_t w = div255( s.t[i] * a );
+		s.r[i] += w * (c >> 11);
+		s.g[i] += w * ((c >> 5) & 0b111111);
+		s.b[i] += w * (c & 0b11111);
+		s.t[i] -= w;
+		if (!s.t[i]) s.open--;
+	}
+
+	/**
+	 * Fetch a run of source pixels behind the span, skipping pixels that are already opaque
+	 */
+	static void underRun( SpanAcc& s, uint16_t i, uint16_t count, const uint8_t* src, PixelFormat pixelFormat, uint32_t transparentColor ){
+		uint16_t end = i + count;
+		uint8_t bpp = pixelFormatByteWidth( pixelFormat );
+		uint32_t fetched = 0, blended = 0;
+		uint16_t c;
+		uint8_t a;
+		for (; i < end; i++, src += bpp){
+			if (!s.t[i]) continue;
+			fetched++;
+			switch (pixelFormat){
+				case mac::PF_565:
+					c = (src[0] << 8) | src[1];
+					if (c != transparentColor) under( s, i, c, 255 );
+					continue;
+				case mac::PF_888:{
+					uint32_t c888 = (src[0] << 16) | (src[1] << 8) | src[2];
+					if (c888 != transparentColor) under( s, i, convert888to565( c888 ), 255 );
+					continue;
+				}
+				case mac::PF_4444: get4444as8565( (uint8_t*)src, c, a ); break;
+				case mac::PF_6666: get6666as8565( (uint8_t*)src, c, a ); break;
+				case mac::PF_8565: c = (src[1] << 8) | src[2]; a = src[0]; break;
+				case mac::PF_8888: c = ((src[1] & 0xF8) << 8) | ((src[2] & 0xFC) << 3) | (src[3] >> 3); a = src[0]; break;
+				case mac::PF_GRAYSCALE: c = convert8to565( src[0] ); a = 255; break;
+				default: fetched--; continue; // XXX: Handle mono and indexed colors
+			}
+			if (a && (a != 255)) blended++;
+			under( s, i, c, a );
+		}
+		if (s.stats){
+			s.stats->fetched += fetched;
+			s.stats->blended += blended;
+			s.stats->occluded += count - fetched;
+		}
+		MAC_STAT_CONVERTED( pixelFormat, fetched );
+		MAC_STAT_ADD( blended, blended );
+		MAC_STAT_ADD( skipped, count - fetched );
+	}
+
+	/**
+	 * Add the pixels of one tile row behind the span
+	 */
+	static void underTileRow( SpanAcc& s, const Tilemap& tilemap, uint16_t tile, int16_t tx, int16_t ty, uint16_t i, uint16_t count, boolean fetch ){
+		if (tile >= tilemap.tileCount) return;
+		if (!fetch){
+			s.stats->occluded += count;
+			return;
+		}
+		uint8_t bpp = pixelFormatByteWidth( tilemap.pixelFormat );
+		const uint8_t* src = tilemap.data + tilemap.tileStride * tile + (ty * tilemap.tileWidth + tx) * bpp;
+		underRun( s, i, count, src, tilemap.pixelFormat, tilemap.transparentColor );
+	}
+
+	/**
+	 * Add a layer behind the span. If fetch is false, only count the occluded pixels.
+	 */
+	static void underLayer( SpanAcc& s, const CompositorLayer& layer, int16_t x0, int16_t y, uint16_t n, boolean fetch ){
+		if (layer.tileLayer){
+			const TileLayer& tl = *layer.tileLayer;
+			if (!tl.tilemap || !tl.map) return;
+			int32_t tw = tl.tilemap->tileWidth;
+			int32_t th = tl.tilemap->tileHeight;
+			int32_t wy = tl.scrollY + y;
+			int32_t row = floorDiv( wy, th );
+			int16_t ty = wy - row * th;
+			int32_t wx = tl.scrollX + x0;
+			uint16_t i = 0;
+			while (i < n){
+				int32_t col = floorDiv( wx + i, tw );
+				int16_t tx = wx + i - col * tw;
+				uint16_t count = min( (int32_t)(n - i), tw - tx );
+				uint16_t tile = tileLayerTile( tl, col, row );
+				if (tile != TILE_NONE) underTileRow( s, *tl.tilemap, tile, tx, ty, i, count, fetch );
+				i += count;
+			}
+		}
+		else{
+			// Sprites are back to front, so walk them in reverse
+			for (int32_t k = layer.spriteCount - 1; k >= 0; k--){
+				const Sprite& sprite = layer.sprites[k];
+				if (!sprite.tilemap) continue;
+				int16_t ty = y - sprite.y;
+				if ((ty < 0) || (ty >= (int16_t)sprite.tilemap->tileHeight)) continue;
+				int16_t sx0 = max( x0, sprite.x );
+				int16_t sx1 = min( (int16_t)(x0 + n), (int16_t)(sprite.x + sprite.tilemap->tileWidth) );
+				if (sx1 <= sx0) continue;
+				if (fetch && !s.open){
+					// Opaque already, but keep counting what is behind
+					if (!s.stats) return;
+					fetch = false;
+				}
+				underTileRow( s, *sprite.tilemap, sprite.tile, sx0 - sprite.x, ty, sx0 - x0, sx1 - sx0, fetch );
+			}
+		}
+	}
+
+	/**
+	 * Composite layers into the framebuffer
+	 */
+	void compositeLayers565(
+		Framebuffer& fb,
+		const CompositorLayer* layers,
+		uint8_t layerCount,
+		color565 background,
+		const Rect* clip,
+		OverdrawStats* stats
+	){
+		MAC_STAT_TIMER( RS_COMPOSITE );
+		MAC_TRACE_SCOPE( "composite" );
+		Rect area = framebufferRect( fb );
+		if (clip && !rectIntersect( area, *clip, area )) return;
+
+		uint16_t bgR = background >> 11;
+		uint16_t bgG = (background >> 5) & 0b111111;
+		uint16_t bgB = background & 0b11111;
+		SpanAcc s;
+		s.stats = stats;
+
+		for (int16_t y = area.y; y < area.y + area.h; y++){
+			color565* dst = fb.data + y * fb.width + area.x;
+			for (int16_t x0 = area.x; x0 < area.x + area.w; x0 += MAC_COMPOSITOR_SPAN){
+				uint16_t n = min( (int16_t)(area.x + area.w - x0), (int16_t)MAC_COMPOSITOR_SPAN );
+				for (uint16_t i = 0; i < n; i++){
+					s.t[i] = 255;
+					s.r[i] = s.g[i] = s.b[i] = 0;
+				}
+				s.open = n;
+
+				// Front to back. Once opaque, remaining layers are only counted (if collecting stats).
+				for (int16_t l = layerCount - 1; l >= 0; l--){
+					if (!s.open){
+						if (!stats) break;
+						underLayer( s, layers[l], x0, y, n, false );
+						continue;
+					}
+					underLayer( s, layers[l], x0, y, n, true );
+					if (!s.open && stats && (l > 0)) stats->earlyOuts++;
+				}
+
+				// Whatever still shows through is background
+				for (uint16_t i = 0; i < n; i++){
+					uint16_t t = s.t[i];
+					*dst++ = (div255( s.r[i] + t * bgR + 127 ) << 11)
+						| (div255( s.g[i] + t * bgG + 127 ) << 5)
+						| div255( s.b[i] + t * bgB + 127 );
+				}
+				if (stats){
+					stats->pixels += n;
+					stats->spans++;
+				}
+			}
+		}
+	}
+
+} // ns
@@ -0,0 +1,127 @@
+/**
+ * Front to back compositing of tile layers and sprites
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ *
+ * MIT LICENCE
+ * -----------
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef _MAC_COMPOSITORH_
+#define _MAC_COMPOSITORH_ 1
+
+#include "Bitmap.h"
+#include "Blit.h"
+#include "TileLayer.h"
+
+/**
+ * Number of pixels resolved together. Longer spans use more stack (14 bytes per pixel).
+ **/
+#ifndef MAC_COMPOSITOR_SPAN
+	#define MAC_COMPOSITOR_SPAN 64
+#endif
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * A single tile drawn at a framebuffer position
+	 **/
+	typedef struct SpriteS {
+		const Tilemap* tilemap;				// The tilemap holding the sprite
+		uint16_t tile;						// Index of the tile in the tilemap
+		int16_t x;							// Framebuffer x position
+		int16_t y;							// Framebuffer y position
+	} Sprite;
+
+	/**
+	 * One layer of the compositor. Either a tile layer, or a set of sprites (in which case
+	 * tileLayer is 0). Sprites in a layer are in back to front order.
+	 **/
+	typedef struct CompositorLayerS {
+		const TileLayer* tileLayer;			// A tile layer, or 0 for a sprite layer
+		const Sprite* sprites;				// The sprites of a sprite layer
+		uint16_t spriteCount;				// Number of sprites
+	} CompositorLayer;
+
+	/**
+	 * Overdraw statistics from compositing a frame. Painting back to front would have fetched
+	 * fetched + occluded source pixels; the compositor only fetched 'fetched' of them.
+	 **/
+	typedef struct OverdrawStatsS {
+		uint32_t pixels;					// Output pixels resolved
+		uint32_t fetched;					// Source pixels fetched and converted
+		uint32_t blended;					// Fetched pixels that were partly transparent
+		uint32_t occluded;					// Source pixels skipped because they were behind opaque pixels
+		uint32_t spans;						// Spans resolved
+		uint32_t earlyOuts;					// Spans that were fully opaque before the last layer
+	} OverdrawStats;
+
+	/**
+	 * Reset overdraw statistics to zero
+	 * @param stats 	The statistics
+	 */
+	inline void overdrawStatsReset( OverdrawStats& stats ){
+		stats = { 0, 0, 0, 0, 0, 0 };
+	}
+
+	/**
+	 * Average number of source pixels fetched per output pixel (1.0 is no overdraw)
+	 * @param  stats 	The statistics
+	 * @return       	The overdraw factor
+	 */
+	inline float overdrawFactor( const OverdrawStats& stats ){
+		return stats.pixels ? (float)stats.fetched / stats.pixels : 0;
+	}
+
+	/**
+	 * Composite layers into the framebuffer. Each span of output pixels is resolved front to
+	 * back: a source pixel is only fetched and converted if the pixels in front of it are not
+	 * already opaque, and the remaining layers are skipped as soon as the whole span is opaque.
+	 * PF_565 and PF_888 sources are opaque except for their transparent color. Whatever is left
+	 * uncovered shows the background color, and every pixel in the clip area is written.
+	 * @param fb 			The framebuffer to draw into
+	 * @param layers 		The layers, back to front (same order as painting)
+	 * @param layerCount 	The number of layers
+	 * @param background 	The color behind the back layer
+	 * @param clip 			Optional clip rectangle (in addition to the framebuffer bounds)
+	 * @param stats 		Optional overdraw statistics to add to
+	 */
+	void compositeLayers565(
+		Framebuffer& fb,
+		const CompositorLayer* layers,
+		uint8_t layerCount,
+		color565 background,
+		const Rect* clip = 0,
+		OverdrawStats* stats = 0
+	);
+
+} // ns
+
+#endif
@@ -0,0 +1,192 @@
+/**
+ * GUI library for "mac/μac"
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ **/
+
+#include "Compress.h"
+#include "RenderStats.h"
+#include "Trace.h"
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * Read an LZ4 length that continues in extra bytes while they are 255
+	 */
+	static inline boolean lzLength( const uint8_t*& src, const uint8_t* end, uint32_t& length ){
+		uint8_t b;
+		do {
+			if (src >= end) return false;
+			b = *src++;
+			length += b;
+		} while (b == 255);
+		return true;
+	}
+
+	/**
+	 * Decompress one LZ4 block
+	 */
+	uint32_t lzDecompress( const uint8_t* src, uint32_t srcSize, uint8_t* dst, uint32_t dstSize ){
+		const uint8_t* end = src + srcSize;
+		uint8_t* d = dst;
+		uint8_t* dend = dst + dstSize;
+		while (src < end){
+			uint8_t token = *src++;
+
+			// Literals
+			uint32_t length = token >> 4;
+			if ((length == 15) && !lzLength( src, end, length )) return 0;
+			if ((length > (uint32_t)(end - src)) || (length > (uint32_t)(dend - d))) return 0;
+			memcpy( d, src, length );
+			d += length;
+			src += length;
+			if (src >= end) break;
+
+			// Match
+			if (end - src < 2) return 0;
+			uint32_t offset = src[0] | (src[1] << 8);
+			src += 2;
+			length = token & 15;
+			if ((length == 15) && !lzLength( src, end, length )) return 0;
+			length += 4;
+			if (!offset || (offset > (uint32_t)(d - dst)) || (length > (uint32_t)(dend - d))) return 0;
+			const uint8_t* m = d - offset;
+			if (offset >= length){
+				memcpy( d, m, length );
+				d += length;
+			}
+			else {
+				// Overlapping match repeats the last offset bytes
+				while (length--) *d++ = *m++;
+			}
+		}
+		return d - dst;
+	}
+
+	/**
+	 * Decompress one block of a compressed tilemap
+	 */
+	boolean decompressBlock( const CompressedTilemap& ct, uint32_t block, uint8_t* dst ){
+		if (block >= ct.blockCount) return false;
+		uint32_t start = ct.offsets[ block ];
+		uint32_t size = ct.offsets[ block + 1 ] - start;
+		uint32_t expected = min( ct.blockSize, ct.tilemap.dataSize - block * ct.blockSize );
+		return lzDecompress( ct.data + start, size, dst, expected ) == expected;
+	}
+
+	/**
+	 * Decompress one tile
+	 */
+	boolean decompressTile( const CompressedTilemap& ct, uint16_t index, uint8_t* dst ){
+		MAC_TRACE_SCOPE( "decompress" );
+		if ((index >= ct.tilemap.tileCount) || !ct.blockSize) return false;
+		// Blocks must not cross from one tile into the next, so nothing outside of dst is written
+		if (ct.tilemap.tileCount > 1){
+			if (ct.tilemap.tileStride % ct.blockSize) return false;
+		}
+		else if (ct.tilemap.dataSize > ct.tilemap.tileStride) return false;
+		uint32_t first = index * ct.tilemap.tileStride;
+		uint32_t last = first + ct.tilemap.tileStride;
+		for (uint32_t block = first / ct.blockSize; block * ct.blockSize < last; block++){
+			if (!decompressBlock( ct, block, dst + block * ct.blockSize - first )) return false;
+		}
+		return true;
+	}
+
+	/**
+	 * Decompress a tile and draw it into a framebuffer
+	 */
+	boolean drawCompressedTile565(
+		Framebuffer& fb,
+		const CompressedTilemap& ct,
+		uint16_t index,
+		int16_t x,
+		int16_t y,
+		uint8_t* buffer,
+		const Rect* clip,
+		const ColorRemap* remap,
+		const BlitEffects* fx
+	){
+		// Skip the decode if the tile is not visible
+		Rect area = framebufferRect( fb );
+		Rect dest = { x, y, (int16_t)ct.tilemap.tileWidth, (int16_t)ct.tilemap.tileHeight };
+		if ((clip && !rectIntersect( area, *clip, area )) || !rectIntersect( area, dest, area )){
+			MAC_STAT_ADD( tilesCulled, 1 );
+			return false;
+		}
+		if (!decompressTile( ct, index, buffer )) return false;
+		Tilemap tile = ct.tilemap;
+		tile.data = buffer;
+		tile.dataSize = tile.tileStride;
+		tile.tileCount = 1;
+		return drawTile565( fb, tile, 0, x, y, &area, remap, fx );
+	}
+
+	/**
+	 * Draw a large compressed tile band by band
+	 */
+	boolean drawCompressedBands565(
+		Framebuffer& fb,
+		const CompressedTilemap& ct,
+		uint16_t index,
+		int16_t x,
+		int16_t y,
+		uint8_t* buffer,
+		const Rect* clip
+	){
+		Rect area = framebufferRect( fb );
+		Rect dest = { x, y, (int16_t)ct.tilemap.tileWidth, (int16_t)ct.tilemap.tileHeight };
+		if ((clip && !rectIntersect( area, *clip, area )) || !rectIntersect( area, dest, area )) return false;
+		if (index >= ct.tilemap.tileCount) return false;
+		uint32_t rowBytes = ct.tilemap.tileWidth * pixelFormatByteWidth( ct.tilemap.pixelFormat );
+		uint16_t bandRows = compressedBandRows( ct );
+		if (!bandRows || (ct.blockSize % rowBytes)) return false;
+		if ((ct.tilemap.tileCount > 1) && (ct.tilemap.tileStride % ct.blockSize)) return false;
+
+		// Only the bands that touch the visible rows
+		uint32_t firstBlock = index * ct.tilemap.tileStride / ct.blockSize;
+		uint16_t band0 = (area.y - y) / bandRows;
+		uint16_t band1 = (area.y + area.h - 1 - y) / bandRows;
+		BitmapView dst = framebufferView( fb );
+		for (uint16_t band = band0; band <= band1; band++){
+			if (!decompressBlock( ct, firstBlock + band, buffer )) return false;
+			uint16_t rows = min( (uint32_t)bandRows, ct.tilemap.tileHeight - band * bandRows );
+			BitmapView view = { buffer, (uint16_t)ct.tilemap.tileWidth, rows, rowBytes, ct.tilemap.pixelFormat, ct.tilemap.transparentColor, false };
+			drawView565( dst, view, x, y + band * bandRows, &area );
+		}
+		return true;
+	}
+
+	/**
+	 * Benchmark the compression ratio against decode speed of a compressed tilemap
+	 */
+	CompressionBenchmark benchmarkDecompress( const CompressedTilemap& ct, uint8_t* buffer, uint16_t passes, Print* out ){
+		CompressionBenchmark result;
+		if (!passes) passes = 1;
+		result.rawBytes = ct.tilemap.dataSize;
+		result.compressedBytes = ct.offsets[ ct.blockCount ] + (ct.blockCount + 1) * 4;
+		result.ratio = (float)result.rawBytes / result.compressedBytes;
+		uint32_t start = micros();
+		for (uint16_t p = 0; p < passes; p++){
+			for (uint32_t block = 0; block < ct.blockCount; block++) decompressBlock( ct, block, buffer );
+		}
+		uint32_t us = max( micros() - start, (uint32_t)1 );
+		result.usPerBlock = (float)us / ((uint32_t)passes * max( ct.blockCount, (uint32_t)1 ));
+		result.mbPerSecond = (float)result.rawBytes * passes / us;
+		if (out){
+			char line[100];
+			snprintf( line, sizeof(line), "%lu -> %lu bytes (%.2fx), %.1f us/block, %.1f MB/s\n",
+				(unsigned long)result.rawBytes, (unsigned long)result.compressedBytes, result.ratio, result.usPerBlock, result.mbPerSecond );
+			out->print( line );
+		}
+		return result;
+	}
+
+} // ns
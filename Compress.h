@@ -0,0 +1,166 @@
+/**
+ * Block-compressed tilemaps with tile-granular decoding
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ *
+ * MIT LICENCE
+ * -----------
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef _MAC_COMPRESSH_
+#define _MAC_COMPRESSH_ 1
+
+#include "Bitmap.h"
+#include "Blit.h"
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * A tilemap whose pixel data is compressed in blocks. Each block is compressed on its own
+	 * in the LZ4 block format, so any tile can be decoded without the ones before it. For
+	 * tiled images a block is one tile. For single images a block is a band of rows.
+	 * tilemap_to_h.py outputs these with the z-lz option.
+	 **/
+	typedef struct CompressedTilemapS {
+		Tilemap tilemap;					// The tilemap as if uncompressed (data is 0)
+		const uint8_t* data;				// The compressed blocks
+		const uint32_t* offsets;			// Start of each block in data (blockCount + 1 entries)
+		uint32_t blockCount;				// Number of blocks
+		uint32_t blockSize;					// Uncompressed size of each block in bytes
+	} CompressedTilemap;
+
+	/**
+	 * Decompress one LZ4 block. Nothing outside of dst is written, even if src is corrupt.
+	 * @param  src 		The compressed data
+	 * @param  srcSize 	Size of the compressed data in bytes
+	 * @param  dst 		The buffer to decompress into
+	 * @param  dstSize 	Size of the buffer in bytes
+	 * @return       	Number of bytes written, or 0 if src is corrupt or dst is too small
+	 */
+	uint32_t lzDecompress( const uint8_t* src, uint32_t srcSize, uint8_t* dst, uint32_t dstSize );
+
+	/**
+	 * Decompress one block of a compressed tilemap
+	 * @param  ct 		The compressed tilemap
+	 * @param  block 	The block index
+	 * @param  dst 		The buffer to decompress into (blockSize bytes)
+	 * @return       	False if the block does not exist or is corrupt
+	 */
+	boolean decompressBlock( const CompressedTilemap& ct, uint32_t block, uint8_t* dst );
+
+	/**
+	 * Decompress one tile. Only the blocks that hold the tile are decoded.
+	 * @param  ct 		The compressed tilemap
+	 * @param  index 	The tile index
+	 * @param  dst 		The buffer to decompress into (tileStride bytes, 4-byte aligned)
+	 * @return       	False if the tile does not exist or is corrupt, or if blocks cross tiles
+	 */
+	boolean decompressTile( const CompressedTilemap& ct, uint16_t index, uint8_t* dst );
+
+	/**
+	 * Number of rows of a tile in each block, for decompressing single images band by band
+	 * @param  ct 		The compressed tilemap
+	 * @return       	Rows per block
+	 */
+	inline uint16_t compressedBandRows( const CompressedTilemap& ct ){
+		return ct.blockSize / (ct.tilemap.tileWidth * pixelFormatByteWidth( ct.tilemap.pixelFormat ));
+	}
+
+	/**
+	 * Decompress a tile and draw it into a framebuffer
+	 * @param  fb 		The framebuffer to draw into
+	 * @param  ct 		The compressed tilemap
+	 * @param  index 	The tile index
+	 * @param  x 		Destination x
+	 * @param  y 		Destination y
+	 * @param  buffer 	Scratch memory for the tile (tileStride bytes, 4-byte aligned)
+	 * @param  clip 	Optional clip rectangle (in addition to the framebuffer bounds)
+	 * @param  remap 	Optional color remap
+	 * @param  fx 		Optional color effects
+	 * @return       	False if nothing was drawn
+	 */
+	boolean drawCompressedTile565(
+		Framebuffer& fb,
+		const CompressedTilemap& ct,
+		uint16_t index,
+		int16_t x,
+		int16_t y,
+		uint8_t* buffer,
+		const Rect* clip = 0,
+		const ColorRemap* remap = 0,
+		const BlitEffects* fx = 0
+	);
+
+	/**
+	 * Draw a large compressed tile (usually a single image) band by band, so only a band
+	 * needs to fit in memory. Bands outside the clip area are not decoded.
+	 * @param  fb 		The framebuffer to draw into
+	 * @param  ct 		The compressed tilemap
+	 * @param  index 	The tile index
+	 * @param  x 		Destination x
+	 * @param  y 		Destination y
+	 * @param  buffer 	Scratch memory for one block (blockSize bytes, 4-byte aligned)
+	 * @param  clip 	Optional clip rectangle (in addition to the framebuffer bounds)
+	 * @return       	False if nothing was drawn
+	 */
+	boolean drawCompressedBands565(
+		Framebuffer& fb,
+		const CompressedTilemap& ct,
+		uint16_t index,
+		int16_t x,
+		int16_t y,
+		uint8_t* buffer,
+		const Rect* clip = 0
+	);
+
+	/**
+	 * Result of the decompression benchmark
+	 **/
+	typedef struct CompressionBenchmarkS {
+		uint32_t rawBytes;					// Uncompressed size
+		uint32_t compressedBytes;			// Compressed size, including the block offsets
+		float ratio;						// rawBytes / compressedBytes
+		float usPerBlock;					// Time to decompress one block, in microseconds
+		float mbPerSecond;					// Decompressed megabytes per second
+	} CompressionBenchmark;
+
+	/**
+	 * Benchmark the compression ratio against decode speed of a compressed tilemap
+	 * @param  ct 		The compressed tilemap
+	 * @param  buffer 	Scratch memory for one block (blockSize bytes)
+	 * @param  passes 	Number of times to decompress every block
+	 * @param  out 		Optional output to print a report to
+	 * @return        	The result
+	 */
+	CompressionBenchmark benchmarkDecompress( const CompressedTilemap& ct, uint8_t* buffer, uint16_t passes, Print* out = 0 );
+
+} // ns
+
+#endif
@@ -0,0 +1,113 @@
+/**
+ * GUI library for "mac/μac"
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ **/
+
+#include "DeltaAnimation.h"
+#include "RenderStats.h"
+#include "Trace.h"
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * Add a dirty rectangle, merging it into the last one if there is no room
+	 */
+	static void addDirty( Rect* dirty, uint16_t maxDirty, uint16_t& count, const Rect& rect ){
+		if (!dirty || !maxDirty) return;
+		if (count < maxDirty) dirty[ count++ ] = rect;
+		else rectUnion( dirty[ count - 1 ], rect, dirty[ count - 1 ] );
+	}
+
+	/**
+	 * Apply one frame's changes, adding to the dirty rectangles
+	 */
+	static void applyFrame( Framebuffer& fb, const DeltaAnimation& anim, uint16_t frame, int16_t x, int16_t y, Rect* dirty, uint16_t maxDirty, uint16_t& count ){
+		if (frame > anim.frameCount) return;
+		Rect area = framebufferRect( fb );
+		const uint16_t* p = anim.data + anim.frames[ frame ];
+		uint16_t rects = *p++;
+		while (rects--){
+			Rect rect = { (int16_t)(x + p[0]), (int16_t)(y + p[1]), (int16_t)p[2], (int16_t)p[3] };
+			const color565* pixels = p + 4;
+			p = pixels + rect.w * rect.h;
+			Rect part;
+			if (!rectIntersect( area, rect, part )) continue;
+			const color565* src = pixels + (part.y - rect.y) * rect.w + (part.x - rect.x);
+			color565* dst = fb.data + part.y * fb.width + part.x;
+			for (int16_t row = 0; row < part.h; row++){
+				memcpy( dst, src, part.w * 2 );
+				src += rect.w;
+				dst += fb.width;
+			}
+			MAC_STAT_ADD( copied, part.w * part.h );
+			addDirty( dirty, maxDirty, count, part );
+		}
+	}
+
+	/**
+	 * Apply one frame's changes in place
+	 */
+	uint16_t deltaApplyFrame( Framebuffer& fb, const DeltaAnimation& anim, uint16_t frame, int16_t x, int16_t y, Rect* dirty, uint16_t maxDirty ){
+		MAC_TRACE_SCOPE( "delta" );
+		uint16_t count = 0;
+		applyFrame( fb, anim, frame, x, y, dirty, maxDirty, count );
+		return count;
+	}
+
+	/**
+	 * Start playing an animation
+	 */
+	void deltaPlayerInit( DeltaPlayer& player, const DeltaAnimation& anim, boolean loop ){
+		player.animation = &anim;
+		player.frame = anim.frameCount;
+		player.nextTime = 0;
+		player.loop = loop;
+	}
+
+	/**
+	 * Show the frames that are due
+	 */
+	uint16_t deltaPlayerUpdate( DeltaPlayer& player, Framebuffer& fb, int16_t x, int16_t y, uint32_t now, Rect* dirty, uint16_t maxDirty ){
+		MAC_TRACE_SCOPE( "delta" );
+		const DeltaAnimation& anim = *player.animation;
+		uint16_t count = 0;
+		if (!anim.frameCount) return 0;
+
+		// The first frame is the keyframe
+		if (player.frame == anim.frameCount){
+			applyFrame( fb, anim, 0, x, y, dirty, maxDirty, count );
+			player.frame = 0;
+			player.nextTime = now + anim.frameTime;
+			return count;
+		}
+		// Whole loops that were missed leave the screen as it was
+		uint32_t loopTime = anim.frameTime * anim.frameCount;
+		if (player.loop && loopTime && ((int32_t)(now - player.nextTime) >= (int32_t)loopTime)){
+			player.nextTime += ((now - player.nextTime) / loopTime) * loopTime;
+		}
+		while ((int32_t)(now - player.nextTime) >= 0){
+			if (deltaPlayerDone( player )) break;
+			if (player.frame + 1 < anim.frameCount){
+				player.frame++;
+				applyFrame( fb, anim, player.frame, x, y, dirty, maxDirty, count );
+			}
+			else {
+				// The change from the last frame back to the first
+				player.frame = 0;
+				applyFrame( fb, anim, anim.frameCount, x, y, dirty, maxDirty, count );
+			}
+			player.nextTime += anim.frameTime;
+			if (!anim.frameTime) break;
+		}
+		return count;
+	}
+
+} // ns
@@ -0,0 +1,119 @@
+/**
+ * Delta-encoded full screen animations
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ *
+ * MIT LICENCE
+ * -----------
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef _MAC_DELTAANIMATIONH_
+#define _MAC_DELTAANIMATIONH_ 1
+
+#include "Bitmap.h"
+#include "Blit.h"
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * An animation stored as a keyframe and the changes from each frame to the next. Each
+	 * frame is a list of rectangles of native color565 pixels that replace what is on screen:
+	 *   rectCount, then for each rect: x, y, w, h, w x h pixels
+	 * Frame 0 is the keyframe (one rectangle covering the whole animation). Frame frameCount
+	 * is the change from the last frame back to frame 0, for looping.
+	 * tilemap_to_h.py outputs these from a sprite sheet with the d- option.
+	 **/
+	typedef struct DeltaAnimationS {
+		const uint16_t* data;				// The rectangles of every frame
+		const uint32_t* frames;				// Start of each frame in data (frameCount + 2 entries)
+		uint16_t frameCount;				// Number of frames
+		uint16_t width;						// Width of the animation
+		uint16_t height;					// Height of the animation
+		uint16_t frameTime;					// Time of each frame in milliseconds
+	} DeltaAnimation;
+
+	/**
+	 * Plays a delta animation into a framebuffer
+	 **/
+	typedef struct DeltaPlayerS {
+		const DeltaAnimation* animation;	// The animation
+		uint16_t frame;						// The frame on screen (frameCount before the first)
+		uint32_t nextTime;					// Clock time of the next frame
+		boolean loop;						// Go back to frame 0 after the last frame
+	} DeltaPlayer;
+
+	/**
+	 * Apply one frame's changes in place. The framebuffer must hold the previous frame
+	 * (any content for frame 0). Pixels outside the framebuffer are skipped.
+	 * @param  fb 			The framebuffer
+	 * @param  anim 		The animation
+	 * @param  frame 		The frame (frameCount for the change back to frame 0)
+	 * @param  x 			Framebuffer x of the animation
+	 * @param  y 			Framebuffer y of the animation
+	 * @param  dirty 		(out) The changed areas of the framebuffer. May be 0.
+	 * @param  maxDirty 	Room in dirty. Extra areas are merged into the last one.
+	 * @return 				Number of dirty rectangles written
+	 */
+	uint16_t deltaApplyFrame( Framebuffer& fb, const DeltaAnimation& anim, uint16_t frame, int16_t x, int16_t y, Rect* dirty = 0, uint16_t maxDirty = 0 );
+
+	/**
+	 * Start playing an animation. The next update shows frame 0.
+	 * @param player 	The player
+	 * @param anim 		The animation
+	 * @param loop 		True to loop
+	 */
+	void deltaPlayerInit( DeltaPlayer& player, const DeltaAnimation& anim, boolean loop = false );
+
+	/**
+	 * Show the frames that are due. If updates are late, every missed frame is applied so
+	 * the framebuffer stays correct.
+	 * @param  player 		The player
+	 * @param  fb 			The framebuffer (not changed by anything else between updates)
+	 * @param  x 			Framebuffer x of the animation
+	 * @param  y 			Framebuffer y of the animation
+	 * @param  now 			The clock time (e.g. millis())
+	 * @param  dirty 		(out) The changed areas of the framebuffer, to send to the display
+	 * @param  maxDirty 	Room in dirty. Extra areas are merged into the last one.
+	 * @return 				Number of dirty rectangles (0 if nothing changed)
+	 */
+	uint16_t deltaPlayerUpdate( DeltaPlayer& player, Framebuffer& fb, int16_t x, int16_t y, uint32_t now, Rect* dirty, uint16_t maxDirty );
+
+	/**
+	 * Check if a player that does not loop has shown its last frame
+	 * @param  player 	The player
+	 * @return        	True if done
+	 */
+	inline boolean deltaPlayerDone( const DeltaPlayer& player ){
+		return !player.loop && (player.frame + 1 == player.animation->frameCount);
+	}
+
+} // ns
+
+#endif
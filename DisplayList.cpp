@@ -0,0 +1,214 @@
+/**
+ * GUI library for "mac/μac"
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ **/
+
+#include "DisplayList.h"
+#include "RenderStats.h"
+#include "Trace.h"
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/*
+	 * ### COMMANDS
+	 */
+
+	DrawCommand drawCommandFill( const Rect& rect, color565 color ){
+		return { DC_FILL, mac::PF_565, 0, 0, rect, 0, 0, color };
+	}
+
+	DrawCommand drawCommandTile( const Tilemap& tilemap, uint16_t tile, int16_t x, int16_t y ){
+		Rect bounds = { x, y, (int16_t)tilemap.tileWidth, (int16_t)tilemap.tileHeight };
+		return { DC_TILE, (uint8_t)tilemap.pixelFormat, 0, 0, bounds, &tilemap, 0, tile };
+	}
+
+	DrawCommand drawCommandBitmap( const Bitmap& bitmap, int16_t x, int16_t y ){
+		Rect bounds = { x, y, (int16_t)bitmap.width, (int16_t)bitmap.height };
+		return { DC_BITMAP, (uint8_t)bitmap.pixelFormat, 0, 0, bounds, &bitmap, 0, 0 };
+	}
+
+	DrawCommand drawCommandText( const Font& font, const char* text, int16_t x, int16_t y, color565 color ){
+		Rect bounds = { x, y, textExtent( font, text ), (int16_t)font.glyphs->tileHeight };
+		return { DC_TEXT, (uint8_t)font.glyphs->pixelFormat, 0, 0, bounds, &font, text, color };
+	}
+
+	/**
+	 * Record a command
+	 */
+	boolean displayListAdd( DisplayList& list, const DrawCommand& command ){
+		if (list.count >= list.capacity) return false;
+		DrawCommand& c = list.commands[list.count];
+		c = command;
+		c.order = list.count++;
+		list.sorted = false;
+		return true;
+	}
+
+	/*
+	 * ### EXECUTION
+	 */
+
+	static int compareOrder( const void* a, const void* b ){
+		return (int)((const DrawCommand*)a)->order - (int)((const DrawCommand*)b)->order;
+	}
+
+	/**
+	 * Paint level first, then state (pixel format and source), then recording order
+	 */
+	static int compareBatch( const void* a, const void* b ){
+		const DrawCommand* ca = (const DrawCommand*)a;
+		const DrawCommand* cb = (const DrawCommand*)b;
+		if (ca->level != cb->level) return (int)ca->level - (int)cb->level;
+		if (ca->pixelFormat != cb->pixelFormat) return (int)ca->pixelFormat - (int)cb->pixelFormat;
+		if (ca->source != cb->source) return ((uintptr_t)ca->source < (uintptr_t)cb->source) ? -1 : 1;
+		return (int)ca->order - (int)cb->order;
+	}
+
+	/**
+	 * Sort the commands into batches
+	 */
+	void displayListSort( DisplayList& list ){
+		if (list.sorted) return;
+		DrawCommand* c = list.commands;
+
+		// Levels are worked out in recording order
+		qsort( c, list.count, sizeof(DrawCommand), compareOrder );
+		for (uint16_t i = 0; i < list.count; i++){
+			uint16_t level = 0;
+			for (uint16_t j = 0; j < i; j++){
+				if ((c[j].level >= level) && rectOverlaps( c[i].bounds, c[j].bounds )) level = c[j].level + 1;
+			}
+			c[i].level = level;
+		}
+		qsort( c, list.count, sizeof(DrawCommand), compareBatch );
+		list.sorted = true;
+	}
+
+	/**
+	 * Sort (if not already sorted) and draw all commands in one pass
+	 */
+	uint16_t displayListExecute( DisplayList& list, Framebuffer& fb, const Rect* clip ){
+		MAC_STAT_TIMER( RS_DISPLAY_LIST );
+		MAC_TRACE_SCOPE( "displayList" );
+		displayListSort( list );
+		list.batches = 0;
+
+		// Source state, only worked out when the source changes
+		const void* source = 0;
+		uint8_t type = 0xff;
+		const uint8_t* data = 0;
+		PixelFormat pixelFormat = mac::PF_UNKNOWN;
+		uint32_t transparentColor = 0;
+		uint32_t rowStride = 0;
+		uint32_t tileStride = 0;
+		uint16_t w = 0, h = 0;
+		uint32_t tileCount = 0;
+
+		for (uint16_t i = 0; i < list.count; i++){
+			const DrawCommand& c = list.commands[i];
+			if ((c.source != source) || (c.type != type)){
+				source = c.source;
+				type = c.type;
+				list.batches++;
+				if (c.type == DC_TILE){
+					const Tilemap& tilemap = *(const Tilemap*)source;
+					data = tilemap.data;
+					pixelFormat = tilemap.pixelFormat;
+					transparentColor = tilemap.transparentColor;
+					rowStride = tilemap.tileWidth * pixelFormatByteWidth( pixelFormat );
+					tileStride = tilemap.tileStride;
+					tileCount = tilemap.tileCount;
+					w = tilemap.tileWidth;
+					h = tilemap.tileHeight;
+				}
+			}
+			switch (c.type){
+				case DC_FILL:{
+					Rect area = c.bounds;
+					if (clip && !rectIntersect( area, *clip, area )) break;
+					fillRect565( fb, area, c.value );
+					break;
+				}
+				case DC_TILE:
+					if (c.value >= tileCount) break;
+					drawPixels565( fb, data + tileStride * c.value, pixelFormat, transparentColor, rowStride, w, h, c.bounds.x, c.bounds.y, clip );
+					break;
+				case DC_BITMAP:
+					drawBitmap565( fb, *(const Bitmap*)source, c.bounds.x, c.bounds.y, clip );
+					break;
+				case DC_TEXT:
+					drawText565( fb, *(const Font*)source, c.text, c.bounds.x, c.bounds.y, c.value, clip );
+					break;
+			}
+		}
+		return list.batches;
+	}
+
+	/*
+	 * ### PRODUCER/CONSUMER QUEUE (host only)
+	 */
+	#if MAC_HOST
+
+	DisplayQueue::DisplayQueue( DrawCommand* storage, uint32_t capacity ){
+		_storage = storage;
+
+		// Slots are found with a mask, so use the largest power of 2 that fits
+		while (capacity & (capacity - 1)) capacity &= capacity - 1;
+		_mask = capacity - 1;
+		_head = 0;
+		_tail = 0;
+	}
+
+	/**
+	 * Add a command (producer thread only)
+	 */
+	boolean DisplayQueue::push( const DrawCommand& command ){
+		uint32_t tail = _tail.load( std::memory_order_relaxed );
+		if (tail - _head.load( std::memory_order_acquire ) > _mask) return false;
+		_storage[tail & _mask] = command;
+		_tail.store( tail + 1, std::memory_order_release );
+		return true;
+	}
+
+	/**
+	 * Mark the end of the frame (producer thread only)
+	 */
+	boolean DisplayQueue::endFrame(){
+		DrawCommand end = { DC_END_FRAME, 0, 0, 0, { 0, 0, 0, 0 }, 0, 0, 0 };
+		return push( end );
+	}
+
+	/**
+	 * Take the next command (consumer thread only)
+	 */
+	boolean DisplayQueue::pop( DrawCommand& command ){
+		uint32_t head = _head.load( std::memory_order_relaxed );
+		if (head == _tail.load( std::memory_order_acquire )) return false;
+		command = _storage[head & _mask];
+		_head.store( head + 1, std::memory_order_release );
+		return true;
+	}
+
+	/**
+	 * Move commands from the queue into a display list until the end of a frame
+	 */
+	boolean displayListReceive( DisplayList& list, DisplayQueue& queue ){
+		DrawCommand command;
+		while (queue.pop( command )){
+			if (command.type == DC_END_FRAME) return true;
+			displayListAdd( list, command );
+		}
+		return false;
+	}
+
+	#endif
+
+} // ns
@@ -0,0 +1,244 @@
+/**
+ * Retained display list with state-sorted batching of draw commands
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ *
+ * MIT LICENCE
+ * -----------
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef _MAC_DISPLAYLISTH_
+#define _MAC_DISPLAYLISTH_ 1
+
+#include "Bitmap.h"
+#include "Blit.h"
+#include "Text.h"
+
+#if MAC_HOST
+	#include <atomic>
+#endif
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * Draw command types
+	 **/
+	typedef enum {
+		DC_FILL				= 0,	// Fill bounds with a solid color
+		DC_TILE				= 1,	// Draw a tile from a tilemap
+		DC_BITMAP			= 2,	// Draw a bitmap
+		DC_TEXT				= 3,	// Draw a line of text with drawText565
+		DC_END_FRAME		= 255	// Marks the end of a frame in a DisplayQueue
+	} DrawCommandType;
+
+	/**
+	 * A recorded draw command. Text is not copied, so it must stay valid until the list
+	 * has been executed.
+	 **/
+	typedef struct DrawCommandS {
+		uint8_t type;						// The DrawCommandType
+		uint8_t pixelFormat;				// Pixel format of the source (for sorting)
+		uint16_t level;						// Paint level (set when the list is sorted)
+		uint16_t order;						// Position in the order of recording
+		Rect bounds;						// Area of the framebuffer that is drawn to
+		const void* source;					// The Tilemap, Bitmap or Font (0 for fills)
+		const char* text;					// The text (DC_TEXT only)
+		uint32_t value;						// Fill or text color, or tile index
+	} DrawCommand;
+
+	/**
+	 * A list of draw commands, held in memory supplied by the caller
+	 **/
+	typedef struct DisplayListS {
+		DrawCommand* commands;				// Command storage
+		uint16_t capacity;					// Number of commands that fit
+		uint16_t count;						// Number of commands recorded
+		uint16_t batches;					// Number of batches in the last execute
+		boolean sorted;						// True if the commands are in paint order
+	} DisplayList;
+
+	/**
+	 * Set up a display list
+	 * @param list 		The display list
+	 * @param commands 	Storage for the commands
+	 * @param capacity 	Number of commands that fit in the storage
+	 */
+	inline void displayListInit( DisplayList& list, DrawCommand* commands, uint16_t capacity ){
+		list.commands = commands;
+		list.capacity = capacity;
+		list.count = 0;
+		list.batches = 0;
+		list.sorted = true;
+	}
+
+	/**
+	 * Remove all commands from a display list
+	 * @param list 		The display list
+	 */
+	inline void displayListClear( DisplayList& list ){
+		list.count = 0;
+		list.sorted = true;
+	}
+
+	/*
+	 * ### COMMANDS
+	 */
+
+	/**
+	 * Create a command to fill a rectangle with a solid color
+	 * @param  rect 	The rectangle
+	 * @param  color 	The fill color
+	 * @return       	The command
+	 */
+	DrawCommand drawCommandFill( const Rect& rect, color565 color );
+
+	/**
+	 * Create a command to draw a tile
+	 * @param  tilemap 	The tilemap
+	 * @param  tile 	Index of the tile
+	 * @param  x 		Framebuffer x position
+	 * @param  y 		Framebuffer y position
+	 * @return         	The command
+	 */
+	DrawCommand drawCommandTile( const Tilemap& tilemap, uint16_t tile, int16_t x, int16_t y );
+
+	/**
+	 * Create a command to draw a bitmap
+	 * @param  bitmap 	The bitmap
+	 * @param  x 		Framebuffer x position
+	 * @param  y 		Framebuffer y position
+	 * @return        	The command
+	 */
+	DrawCommand drawCommandBitmap( const Bitmap& bitmap, int16_t x, int16_t y );
+
+	/**
+	 * Create a command to draw a line of text in a solid color, with the font's advances
+	 * and kerning (see drawText565)
+	 * @param  font 		The font
+	 * @param  text 		The text. Not copied.
+	 * @param  x 			Framebuffer x position of the pen
+	 * @param  y 			Framebuffer y position of the top of the line
+	 * @param  color 		The text color
+	 * @return           	The command
+	 */
+	DrawCommand drawCommandText( const Font& font, const char* text, int16_t x, int16_t y, color565 color );
+
+	/**
+	 * Record a command
+	 * @param  list 	The display list
+	 * @param  command 	The command
+	 * @return         	False if the list is full
+	 */
+	boolean displayListAdd( DisplayList& list, const DrawCommand& command );
+
+	/*
+	 * ### EXECUTION
+	 */
+
+	/**
+	 * Sort the commands into batches. Each command is given a paint level one higher than
+	 * the highest earlier command it overlaps, so commands on the same level never overlap and
+	 * can be drawn in any order. Within a level, commands are grouped by pixel format and source.
+	 * This is O(n^2) in the number of commands.
+	 * @param list 		The display list
+	 */
+	void displayListSort( DisplayList& list );
+
+	/**
+	 * Sort (if not already sorted) and draw all commands in one pass. The list is kept, so it
+	 * can be executed again next frame.
+	 * @param  list 	The display list
+	 * @param  fb 		The framebuffer to draw into
+	 * @param  clip 	Optional clip rectangle (in addition to the framebuffer bounds)
+	 * @return      	The number of batches (changes of source) drawn
+	 */
+	uint16_t displayListExecute( DisplayList& list, Framebuffer& fb, const Rect* clip = 0 );
+
+	/*
+	 * ### PRODUCER/CONSUMER QUEUE (host only)
+	 */
+	#if MAC_HOST
+
+	/**
+	 * A lock-free single-producer/single-consumer queue of draw commands. One thread records
+	 * commands and calls endFrame; the render thread moves them into a display list with
+	 * displayListReceive and executes it. Storage is supplied by the caller.
+	 **/
+	class DisplayQueue {
+		public:
+			/**
+			 * Set up the queue
+			 * @param storage 	Storage for the commands
+			 * @param capacity 	Number of commands that fit in the storage (at least 1). If it is
+			 *                 	not a power of 2 it is rounded down to one, and the rest of the
+			 *                 	storage is not used.
+			 */
+			DisplayQueue( DrawCommand* storage, uint32_t capacity );
+
+			/**
+			 * Add a command (producer thread only)
+			 * @return False if the queue is full
+			 */
+			boolean push( const DrawCommand& command );
+
+			/**
+			 * Mark the end of the frame (producer thread only)
+			 * @return False if the queue is full
+			 */
+			boolean endFrame();
+
+			/**
+			 * Take the next command (consumer thread only)
+			 * @return False if the queue is empty
+			 */
+			boolean pop( DrawCommand& command );
+
+		private:
+			DrawCommand* _storage;
+			uint32_t _mask;
+			std::atomic<uint32_t> _head;	// Next slot to read (written by the consumer)
+			std::atomic<uint32_t> _tail;	// Next slot to write (written by the producer)
+	};
+
+	/**
+	 * Move commands from the queue into a display list until the end of a frame
+	 * (consumer thread only). Call again later if it returns false. Commands are added to
+	 * the list, so clear it after executing a frame. Commands that do not fit are dropped.
+	 * @param  list 	The display list
+	 * @param  queue 	The queue
+	 * @return       	True when a whole frame has been received
+	 */
+	boolean displayListReceive( DisplayList& list, DisplayQueue& queue );
+
+	#endif
+
+} // ns
+
+#endif
@@ -0,0 +1,361 @@
+/**
+ * GUI library for "mac/μac"
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ **/
+
+#include "DisplaySink.h"
+#include "Trace.h"
+#if MAC_HOST
+	#include <vector>
+#endif
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * Set up a display sink
+	 */
+	void displaySinkInit( DisplaySink& sink, uint16_t width, uint16_t height, DisplayWindowCallback setWindow, DisplayPixelsCallback writePixels, void* data, color565* buffer, uint32_t bufferSize, boolean swapBytes, uint32_t* cells ){
+		sink.setWindow = setWindow;
+		sink.writePixels = writePixels;
+		sink.data = data;
+		sink.buffer = bufferSize ? buffer : 0;
+		sink.bufferSize = buffer ? bufferSize : 0;
+		sink.swapBytes = swapBytes && sink.buffer;
+		sink.width = width;
+		sink.height = height;
+		sink.dirtyCount = 0;
+		sink.cells = cells;
+		sink.cellCols = (width + MAC_SINK_CELL - 1) / MAC_SINK_CELL;
+		sink.cellRows = (height + MAC_SINK_CELL - 1) / MAC_SINK_CELL;
+		sink.overflow = false;
+		if (cells) memset( cells, 0, displaySinkCellWords( width, height ) * 4 );
+		sink.stats = { 0, 0, 0, 0 };
+	}
+
+	/**
+	 * Number of pixels in a rectangle
+	 */
+	static inline int32_t rectArea( const Rect& r ){
+		return (int32_t)r.w * r.h;
+	}
+
+	/**
+	 * Mark the cells of the overflow grid that a rectangle touches
+	 */
+	static void markCells( DisplaySink& sink, const Rect& r ){
+		uint16_t c0 = r.x / MAC_SINK_CELL;
+		uint16_t c1 = (r.x + r.w - 1) / MAC_SINK_CELL;
+		uint16_t r1 = (r.y + r.h - 1) / MAC_SINK_CELL;
+		for (uint16_t row = r.y / MAC_SINK_CELL; row <= r1; row++){
+			for (uint16_t col = c0; col <= c1; col++){
+				uint32_t cell = (uint32_t)row * sink.cellCols + col;
+				sink.cells[ cell >> 5 ] |= 1u << (cell & 31);
+			}
+		}
+		sink.overflow = true;
+	}
+
+	/**
+	 * Mark an area of the display as changed
+	 */
+	void displaySinkAddDirty( DisplaySink& sink, const Rect& rect ){
+		Rect r;
+		if (!rectIntersect( { 0, 0, (int16_t)sink.width, (int16_t)sink.height }, rect, r )) return;
+
+		while (true){
+			// Merge with any rectangle where sending the union is cheaper than another window.
+			// The merged rectangle is bigger, so check the others again.
+			boolean merged = true;
+			while (merged){
+				merged = false;
+				for (uint8_t i = 0; i < sink.dirtyCount; i++){
+					Rect u;
+					rectUnion( sink.dirty[i], r, u );
+					if (rectArea( u ) <= rectArea( sink.dirty[i] ) + rectArea( r ) + MAC_SINK_WINDOW_COST){
+						r = u;
+						sink.dirty[i] = sink.dirty[ --sink.dirtyCount ];
+						sink.stats.merged++;
+						merged = true;
+						break;
+					}
+				}
+			}
+			if (sink.dirtyCount < MAC_SINK_DIRTY){
+				sink.dirty[ sink.dirtyCount++ ] = r;
+				return;
+			}
+
+			// Full, so merge the pair that sends the fewest extra pixels. The pair is either the
+			// new rectangle and one in the list, or two in the list (index dirtyCount is r).
+			uint8_t bestA = 0;
+			uint8_t bestB = sink.dirtyCount;
+			int32_t bestWaste = INT32_MAX;
+			for (uint8_t a = 0; a < sink.dirtyCount; a++){
+				for (uint8_t b = a + 1; b <= sink.dirtyCount; b++){
+					const Rect& rb = (b == sink.dirtyCount) ? r : sink.dirty[b];
+					Rect u;
+					rectUnion( sink.dirty[a], rb, u );
+					int32_t waste = rectArea( u ) - rectArea( sink.dirty[a] ) - rectArea( rb );
+					if (waste < bestWaste){
+						bestWaste = waste;
+						bestA = a;
+						bestB = b;
+					}
+				}
+			}
+			if (sink.cells && (bestWaste > MAC_SINK_WINDOW_COST)){
+				markCells( sink, r );
+				return;
+			}
+			sink.stats.merged++;
+			Rect u;
+			if (bestB == sink.dirtyCount){
+				rectUnion( sink.dirty[bestA], r, u );
+				sink.dirty[bestA] = sink.dirty[ --sink.dirtyCount ];
+			}
+			else{
+				// r takes the place of the pair, and their union is added next
+				rectUnion( sink.dirty[bestA], sink.dirty[bestB], u );
+				sink.dirty[bestA] = r;
+				sink.dirty[bestB] = sink.dirty[ --sink.dirtyCount ];
+			}
+			r = u;
+		}
+	}
+
+	/**
+	 * Send a rectangle of pixels straight away
+	 */
+	void displaySinkWrite( DisplaySink& sink, const color565* pixels, uint32_t stride, const Rect& rect ){
+		if ((rect.w <= 0) || (rect.h <= 0)) return;
+		uint32_t w = rect.w;
+		uint32_t h = rect.h;
+		sink.setWindow( rect.x, rect.y, rect.w, rect.h, sink.data );
+		sink.stats.windows++;
+		sink.stats.pixels += w * h;
+
+		// Send straight from the pixels if they follow on in memory, if there is no buffer,
+		// or if each row fills the buffer anyway
+		if (!sink.swapBytes && ((stride == w) || (w >= sink.bufferSize))){
+			if (stride == w){
+				sink.writePixels( pixels, w * h, sink.data );
+				sink.stats.writes++;
+				return;
+			}
+			for (uint32_t row = 0; row < h; row++){
+				sink.writePixels( pixels + row * stride, w, sink.data );
+			}
+			sink.stats.writes += h;
+			return;
+		}
+
+		// Gather the rows into the buffer, and send it each time it fills
+		uint32_t fill = 0;
+		for (uint32_t row = 0; row < h; row++){
+			const color565* src = pixels + row * stride;
+			uint32_t left = w;
+			while (left){
+				uint32_t n = min( left, sink.bufferSize - fill );
+				color565* dst = sink.buffer + fill;
+				if (sink.swapBytes){
+					for (uint32_t i = 0; i < n; i++) dst[i] = (color565)((src[i] << 8) | (src[i] >> 8));
+				}
+				else{
+					memcpy( dst, src, n * sizeof(color565) );
+				}
+				fill += n;
+				src += n;
+				left -= n;
+				if (fill == sink.bufferSize){
+					sink.writePixels( sink.buffer, fill, sink.data );
+					sink.stats.writes++;
+					fill = 0;
+				}
+			}
+		}
+		if (fill){
+			sink.writePixels( sink.buffer, fill, sink.data );
+			sink.stats.writes++;
+		}
+	}
+
+	/**
+	 * Send the dirty areas of a framebuffer, and clear them
+	 */
+	uint16_t displaySinkFlush( DisplaySink& sink, const Framebuffer& fb ){
+		MAC_TRACE_SCOPE( "displaySinkFlush" );
+		uint32_t windows = sink.stats.windows;
+		for (uint8_t i = 0; i < sink.dirtyCount; i++){
+			const Rect& r = sink.dirty[i];
+			displaySinkWrite( sink, fb.data + (uint32_t)r.y * fb.width + r.x, fb.width, r );
+		}
+		sink.dirtyCount = 0;
+
+		// Each run of marked cells in a row of the overflow grid is one window
+		if (sink.overflow){
+			for (uint16_t row = 0; row < sink.cellRows; row++){
+				uint32_t base = (uint32_t)row * sink.cellCols;
+				uint16_t col = 0;
+				while (col < sink.cellCols){
+					uint32_t cell = base + col;
+					if (!(sink.cells[ cell >> 5 ] & (1u << (cell & 31)))){
+						col++;
+						continue;
+					}
+					uint16_t start = col;
+					do {
+						sink.cells[ cell >> 5 ] &= ~(1u << (cell & 31));
+						cell = base + ++col;
+					} while ((col < sink.cellCols) && (sink.cells[ cell >> 5 ] & (1u << (cell & 31))));
+					int16_t x = start * MAC_SINK_CELL;
+					int16_t y = row * MAC_SINK_CELL;
+					Rect r = { x, y, (int16_t)(min( col * MAC_SINK_CELL, (int)sink.width ) - x), (int16_t)(min( y + MAC_SINK_CELL, (int)sink.height ) - y) };
+					displaySinkWrite( sink, fb.data + (uint32_t)r.y * fb.width + r.x, fb.width, r );
+				}
+			}
+			sink.overflow = false;
+		}
+		return sink.stats.windows - windows;
+	}
+
+	/**
+	 * Callback for scrollBufferFlush that sends each part to a sink
+	 */
+	void displaySinkScrollCallback( const color565* pixels, uint16_t stride, int16_t x, int16_t y, int16_t w, int16_t h, void* data ){
+		displaySinkWrite( *(DisplaySink*)data, pixels, stride, { x, y, w, h } );
+	}
+
+	/*
+	 * ### SIMULATED SPI DISPLAY (host only)
+	 */
+	#if MAC_HOST
+
+	/**
+	 * Set up a simulated SPI display
+	 */
+	void simulatedSpiInit( SimulatedSpi& spi, uint16_t width, uint16_t height, uint32_t busHz, color565* memory, boolean swapped ){
+		spi.busHz = max( busHz, (uint32_t)1 );
+		spi.transactionUs = 1.0f;
+		spi.swapped = swapped;
+		spi.memory = memory;
+		spi.width = width;
+		spi.height = height;
+		spi.window = { 0, 0, (int16_t)width, (int16_t)height };
+		spi.cursor = 0;
+		spi.commandBytes = 0;
+		spi.dataBytes = 0;
+		spi.transactions = 0;
+		spi.busUs = 0;
+	}
+
+	/**
+	 * Window callback for a simulated SPI display (CASET, PASET and RAMWR)
+	 */
+	void simulatedSpiWindow( int16_t x, int16_t y, int16_t w, int16_t h, void* data ){
+		SimulatedSpi& spi = *(SimulatedSpi*)data;
+		spi.window = { x, y, w, h };
+		spi.cursor = 0;
+		spi.commandBytes += 11;
+		spi.transactions++;
+		spi.busUs += 11 * 8 * 1000000.0f / spi.busHz + spi.transactionUs;
+	}
+
+	/**
+	 * Pixel callback for a simulated SPI display
+	 */
+	void simulatedSpiPixels( const color565* pixels, uint32_t count, void* data ){
+		SimulatedSpi& spi = *(SimulatedSpi*)data;
+		spi.dataBytes += count * 2;
+		spi.transactions++;
+		spi.busUs += count * 16 * 1000000.0f / spi.busHz + spi.transactionUs;
+		if (!spi.memory || (spi.window.w <= 0)) return;
+
+		// Fill the window row by row, like the panel does
+		uint32_t size = (uint32_t)spi.window.w * spi.window.h;
+		for (uint32_t i = 0; (i < count) && (spi.cursor < size); i++, spi.cursor++){
+			int32_t x = spi.window.x + (int32_t)(spi.cursor % spi.window.w);
+			int32_t y = spi.window.y + (int32_t)(spi.cursor / spi.window.w);
+			if ((x < 0) || (y < 0) || (x >= spi.width) || (y >= spi.height)) continue;
+			color565 c = pixels[i];
+			if (spi.swapped) c = (color565)((c << 8) | (c >> 8));
+			spi.memory[ y * spi.width + x ] = c;
+		}
+	}
+
+	/**
+	 * Compare sending dirty rectangles one window each against sending them through a sink
+	 */
+	FlushBenchmark benchmarkFlush( const Framebuffer& fb, const Rect* rects, uint16_t count, uint32_t busHz, Print* out ){
+		FlushBenchmark result;
+		SimulatedSpi spi;
+		DisplaySink sink;
+
+		// One window per rectangle, a write per row
+		simulatedSpiInit( spi, fb.width, fb.height, busHz );
+		displaySinkInit( sink, fb.width, fb.height, simulatedSpiWindow, simulatedSpiPixels, &spi );
+		for (uint16_t i = 0; i < count; i++){
+			Rect r;
+			if (!rectIntersect( framebufferRect( fb ), rects[i], r )) continue;
+			displaySinkWrite( sink, fb.data + (uint32_t)r.y * fb.width + r.x, fb.width, r );
+		}
+		result.naiveWindows = sink.stats.windows;
+		result.naiveBytes = spi.commandBytes + spi.dataBytes;
+		result.naiveUs = spi.busUs;
+
+		// Merged rectangles, gathered into a buffer of a few rows
+		std::vector<color565> buffer( (uint32_t)fb.width * 4 );
+		std::vector<uint32_t> cells( displaySinkCellWords( fb.width, fb.height ) );
+		simulatedSpiInit( spi, fb.width, fb.height, busHz );
+		displaySinkInit( sink, fb.width, fb.height, simulatedSpiWindow, simulatedSpiPixels, &spi, buffer.data(), buffer.size(), false, cells.data() );
+		for (uint16_t i = 0; i < count; i++) displaySinkAddDirty( sink, rects[i] );
+		displaySinkFlush( sink, fb );
+		result.windows = sink.stats.windows;
+		result.bytes = spi.commandBytes + spi.dataBytes;
+		result.us = spi.busUs;
+
+		if (out){
+			char line[120];
+			snprintf( line, sizeof(line), "naive: %lu windows, %lu bytes, %.0f us\nsink:  %lu windows, %lu bytes, %.0f us (%.2fx)\n",
+				(unsigned long)result.naiveWindows, (unsigned long)result.naiveBytes, result.naiveUs,
+				(unsigned long)result.windows, (unsigned long)result.bytes, result.us, result.naiveUs / max( result.us, 1.0f ) );
+			out->print( line );
+		}
+		return result;
+	}
+
+	/**
+	 * Run benchmarkFlush on tiles scattered over the framebuffer
+	 */
+	FlushBenchmark benchmarkFlushScattered( const Framebuffer& fb, uint16_t tileSize, uint16_t count, uint32_t busHz, Print* out ){
+		uint16_t cols = fb.width / max( tileSize, (uint16_t)1 );
+		uint16_t rows = fb.height / max( tileSize, (uint16_t)1 );
+		count = min( count, (uint16_t)(cols * rows) );
+		std::vector<uint8_t> used( cols * rows, 0 );
+		std::vector<Rect> rects;
+		rects.reserve( count );
+
+		// A fixed sequence (xorshift) so every run sends the same tiles
+		uint32_t seed = 2463534242u;
+		while (rects.size() < count){
+			seed ^= seed << 13;
+			seed ^= seed >> 17;
+			seed ^= seed << 5;
+			uint32_t cell = seed % (cols * rows);
+			if (used[cell]) continue;
+			used[cell] = 1;
+			rects.push_back( { (int16_t)((cell % cols) * tileSize), (int16_t)((cell / cols) * tileSize), (int16_t)tileSize, (int16_t)tileSize } );
+		}
+		return benchmarkFlush( fb, rects.data(), count, busHz, out );
+	}
+
+	#endif
+
+} // ns
@@ -0,0 +1,279 @@
+/**
+ * Display output with coalesced, batched window and pixel writes
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ *
+ * MIT LICENCE
+ * -----------
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef _MAC_DISPLAYSINKH_
+#define _MAC_DISPLAYSINKH_ 1
+
+#include "Bitmap.h"
+#include "Blit.h"
+
+/**
+ * Largest number of dirty rectangles a display sink holds before merging them
+ **/
+#ifndef MAC_SINK_DIRTY
+	#define MAC_SINK_DIRTY 64
+#endif
+
+/**
+ * Cost of starting a new window, in pixels. Two dirty rectangles are merged if the merged
+ * rectangle adds fewer pixels than this. About 11 bytes of commands plus the bus turnaround.
+ **/
+#ifndef MAC_SINK_WINDOW_COST
+	#define MAC_SINK_WINDOW_COST 32
+#endif
+
+/**
+ * Size in pixels of the cells of a display sink's overflow grid
+ **/
+#ifndef MAC_SINK_CELL
+	#define MAC_SINK_CELL 8
+#endif
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * Sets the display window that the following pixels fill, row by row
+	 * (for example setAddrWindow on an ILI9341)
+	 * @param x 		Left edge
+	 * @param y 		Top edge
+	 * @param w 		Width
+	 * @param h 		Height
+	 * @param data 		User data
+	 */
+	typedef void (*DisplayWindowCallback)( int16_t x, int16_t y, int16_t w, int16_t h, void* data );
+
+	/**
+	 * Sends pixels to the current window. The pixels may be the sink buffer, which is
+	 * reused as soon as this returns, so wait for any DMA to finish before returning.
+	 * @param pixels 	The pixels
+	 * @param count 	Number of pixels
+	 * @param data 		User data
+	 */
+	typedef void (*DisplayPixelsCallback)( const color565* pixels, uint32_t count, void* data );
+
+	/**
+	 * Counters of a display sink
+	 **/
+	typedef struct DisplaySinkStatsS {
+		uint32_t windows;					// Number of windows set
+		uint32_t writes;					// Number of pixel writes
+		uint32_t pixels;					// Number of pixels sent
+		uint32_t merged;					// Number of dirty rectangles merged into another
+	} DisplaySinkStats;
+
+	/**
+	 * Sends the dirty areas of a framebuffer to a display. Dirty rectangles that are close
+	 * together are merged so that fewer windows are set, and pixels are sent in as few
+	 * writes as possible. With a buffer, rows are gathered into it so that each write is
+	 * as large as the buffer, and can be byte swapped for panels that take big-endian 565.
+	 * When more areas change than there are dirty rectangles, areas that would be expensive
+	 * to merge are marked in an optional grid of cells instead, and sent as runs of cells.
+	 **/
+	typedef struct DisplaySinkS {
+		DisplayWindowCallback setWindow;	// Sets the window
+		DisplayPixelsCallback writePixels;	// Sends pixels
+		void* data;							// User data for the callbacks
+		color565* buffer;					// Optional buffer that rows are gathered into
+		uint32_t bufferSize;				// Size of the buffer in pixels
+		boolean swapBytes;					// Send each pixel high byte first (needs a buffer)
+		uint16_t width;						// Width of the display
+		uint16_t height;					// Height of the display
+		Rect dirty[ MAC_SINK_DIRTY ];		// The dirty rectangles
+		uint8_t dirtyCount;					// Number of dirty rectangles
+		uint32_t* cells;					// Optional overflow grid, one bit per cell
+		uint16_t cellCols;					// Number of columns of cells
+		uint16_t cellRows;					// Number of rows of cells
+		boolean overflow;					// True if any cell is marked
+		DisplaySinkStats stats;				// The counters
+	} DisplaySink;
+
+	/**
+	 * Number of words needed for the overflow grid of a display sink
+	 * @param  width 	Width of the display
+	 * @param  height 	Height of the display
+	 * @return        	Number of 32-bit words
+	 */
+	inline uint32_t displaySinkCellWords( uint16_t width, uint16_t height ){
+		uint32_t cols = (width + MAC_SINK_CELL - 1) / MAC_SINK_CELL;
+		uint32_t rows = (height + MAC_SINK_CELL - 1) / MAC_SINK_CELL;
+		return (cols * rows + 31) >> 5;
+	}
+
+	/**
+	 * Set up a display sink
+	 * @param sink 			The sink
+	 * @param width 		Width of the display
+	 * @param height 		Height of the display
+	 * @param setWindow 	Sets the window
+	 * @param writePixels 	Sends pixels
+	 * @param data 			User data for the callbacks
+	 * @param buffer 		Optional buffer to gather rows into (at least one row is best)
+	 * @param bufferSize 	Size of the buffer in pixels
+	 * @param swapBytes 	Send each pixel high byte first (ignored without a buffer)
+	 * @param cells 		Optional overflow grid (@see displaySinkCellWords)
+	 */
+	void displaySinkInit(
+		DisplaySink& sink,
+		uint16_t width,
+		uint16_t height,
+		DisplayWindowCallback setWindow,
+		DisplayPixelsCallback writePixels,
+		void* data = 0,
+		color565* buffer = 0,
+		uint32_t bufferSize = 0,
+		boolean swapBytes = false,
+		uint32_t* cells = 0
+	);
+
+	/**
+	 * Mark an area of the display as changed. It is merged with a dirty rectangle if that
+	 * costs less than setting another window. When MAC_SINK_DIRTY rectangles are held, the
+	 * two rectangles (old or new) whose union adds the fewest pixels are merged. If even that
+	 * costs more than a window and the sink has an overflow grid, the area is marked in the
+	 * grid instead.
+	 * @param sink 		The sink
+	 * @param rect 		The area (clipped to the display)
+	 */
+	void displaySinkAddDirty( DisplaySink& sink, const Rect& rect );
+
+	/**
+	 * Send a rectangle of pixels straight away
+	 * @param sink 		The sink
+	 * @param pixels 	The top-left pixel
+	 * @param stride 	Number of pixels from one row to the next
+	 * @param rect 		Where the pixels go on the display
+	 */
+	void displaySinkWrite( DisplaySink& sink, const color565* pixels, uint32_t stride, const Rect& rect );
+
+	/**
+	 * Send the dirty areas of a framebuffer, and clear them
+	 * @param  sink 	The sink
+	 * @param  fb 		The framebuffer (the same size as the display)
+	 * @return    		Number of windows set
+	 */
+	uint16_t displaySinkFlush( DisplaySink& sink, const Framebuffer& fb );
+
+	/**
+	 * Callback for scrollBufferFlush that sends each part to a sink. Pass the sink as the data.
+	 */
+	void displaySinkScrollCallback( const color565* pixels, uint16_t stride, int16_t x, int16_t y, int16_t w, int16_t h, void* data );
+
+	/*
+	 * ### SIMULATED SPI DISPLAY (host only)
+	 */
+	#if MAC_HOST
+
+	/**
+	 * A display on a simulated SPI bus, for measuring flushes without hardware. Timing is
+	 * modelled on an ILI9341: each window is 3 command bytes and 8 parameter bytes.
+	 * If the display has memory, pixels are stored in it so that the output can be checked.
+	 **/
+	typedef struct SimulatedSpiS {
+		uint32_t busHz;						// SPI clock in Hz
+		float transactionUs;				// Fixed cost of each window and each write, in microseconds
+		boolean swapped;					// Pixels arrive high byte first
+		color565* memory;					// Optional display memory (width x height)
+		uint16_t width;						// Width of the display
+		uint16_t height;					// Height of the display
+		Rect window;						// The current window
+		uint32_t cursor;					// Next pixel in the window
+		uint32_t commandBytes;				// Command and parameter bytes sent
+		uint32_t dataBytes;					// Pixel bytes sent
+		uint32_t transactions;				// Number of windows and writes
+		float busUs;						// Total time on the bus, in microseconds
+	} SimulatedSpi;
+
+	/**
+	 * Set up a simulated SPI display
+	 * @param spi 			The display
+	 * @param width 		Width of the display
+	 * @param height 		Height of the display
+	 * @param busHz 		SPI clock in Hz (for example 30000000)
+	 * @param memory 		Optional display memory (width x height)
+	 * @param swapped 		Pixels arrive high byte first (set this if the sink swaps bytes)
+	 */
+	void simulatedSpiInit( SimulatedSpi& spi, uint16_t width, uint16_t height, uint32_t busHz, color565* memory = 0, boolean swapped = false );
+
+	/**
+	 * Window callback for a simulated SPI display. Pass the display as the data.
+	 */
+	void simulatedSpiWindow( int16_t x, int16_t y, int16_t w, int16_t h, void* data );
+
+	/**
+	 * Pixel callback for a simulated SPI display. Pass the display as the data.
+	 */
+	void simulatedSpiPixels( const color565* pixels, uint32_t count, void* data );
+
+	/**
+	 * Result of the flush benchmark
+	 **/
+	typedef struct FlushBenchmarkS {
+		uint32_t naiveWindows;				// Windows set with one window per dirty rectangle
+		uint32_t naiveBytes;				// Bytes sent with one window per dirty rectangle
+		float naiveUs;						// Bus time with one window per dirty rectangle
+		uint32_t windows;					// Windows set by the sink
+		uint32_t bytes;						// Bytes sent by the sink
+		float us;							// Bus time through the sink
+	} FlushBenchmark;
+
+	/**
+	 * Compare sending dirty rectangles one window each against sending them through a sink
+	 * @param  fb 		The framebuffer
+	 * @param  rects 	The dirty rectangles (for example one per tile drawn)
+	 * @param  count 	Number of rectangles
+	 * @param  busHz 	SPI clock in Hz
+	 * @param  out 		Optional output to print a report to
+	 * @return       	The result
+	 */
+	FlushBenchmark benchmarkFlush( const Framebuffer& fb, const Rect* rects, uint16_t count, uint32_t busHz, Print* out = 0 );
+
+	/**
+	 * Run benchmarkFlush on tiles scattered over the framebuffer (the same tiles every run),
+	 * for example animated tiles or sprites spread over a map
+	 * @param  fb 		The framebuffer
+	 * @param  tileSize Width and height of each tile
+	 * @param  count 	Number of tiles (at most one per cell of the tile grid)
+	 * @param  busHz 	SPI clock in Hz
+	 * @param  out 		Optional output to print a report to
+	 * @return       	The result
+	 */
+	FlushBenchmark benchmarkFlushScattered( const Framebuffer& fb, uint16_t tileSize, uint16_t count, uint32_t busHz, Print* out = 0 );
+
+	#endif
+
+} // ns
+
+#endif
@@ -0,0 +1,164 @@
+/**
+ * GUI library for "mac/μac"
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ **/
+
+#include "Headless.h"
+
+#if MAC_HOST
+	#include <algorithm>
+	#include <chrono>
+	#include <math.h>
+	#include <stdio.h>
+	#include <vector>
+#endif
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	#if MAC_HOST
+
+	/**
+	 * Load a tilemap from a QOI file
+	 */
+	ImageLoadError headlessLoadQoi( Tilemap& tilemap, Arena& arena, const char* path, PixelFormat pf, uint16_t tileWidth, uint16_t tileHeight ){
+		FILE* file = fopen( path, "rb" );
+		if (!file) return IL_READ;
+		ImageLoadError error = imageLoadQoi( tilemap, arena, imageReadFile, file, pf, tileWidth, tileHeight );
+		fclose( file );
+		return error;
+	}
+
+	/**
+	 * Position after moving from start for a number of frames, bouncing between 0 and range
+	 */
+	static int32_t bounce( float start, float velocity, uint32_t frame, int32_t range ){
+		if (range <= 0) return 0;
+		int32_t period = range * 2;
+		int32_t p = (int32_t)fmodf( floorf( start + velocity * frame ), (float)period );
+		if (p < 0) p += period;
+		return (p <= range) ? p : period - p;
+	}
+
+	/**
+	 * Render one frame of a scene
+	 */
+	void headlessRenderFrame( Framebuffer& fb, const HeadlessScene& scene, uint32_t frame ){
+		fillRect565( fb, framebufferRect( fb ), scene.background );
+		for (uint16_t i = 0; i < scene.itemCount; i++){
+			const HeadlessItem& item = scene.items[i];
+			switch (item.type){
+				case HL_LAYER: {
+					TileLayer& layer = *item.layer;
+					int32_t mapW = layer.mapWidth * layer.tilemap->tileWidth;
+					int32_t mapH = layer.mapHeight * layer.tilemap->tileHeight;
+					layer.scrollX = bounce( item.x, item.vx, frame, mapW - fb.width );
+					layer.scrollY = bounce( item.y, item.vy, frame, mapH - fb.height );
+					renderTileLayer565( fb, layer );
+					break;
+				}
+				case HL_SPRITE: {
+					uint32_t tile = item.tile;
+					if (item.tileCount > 1) tile += (frame / max( item.frameTicks, (uint16_t)1 )) % item.tileCount;
+					int16_t x = bounce( item.x, item.vx, frame, (int32_t)fb.width - (int32_t)item.tilemap->tileWidth );
+					int16_t y = bounce( item.y, item.vy, frame, (int32_t)fb.height - (int32_t)item.tilemap->tileHeight );
+					drawTile565( fb, *item.tilemap, tile, x, y );
+					break;
+				}
+				case HL_TEXT: {
+					char text[ MAC_HEADLESS_TEXT ];
+					snprintf( text, sizeof(text), item.text, (unsigned long)frame );
+					int16_t x = bounce( item.x, item.vx, frame, fb.width - textWidth( *item.font, text ) );
+					int16_t y = bounce( item.y, item.vy, frame, (int32_t)fb.height - (int32_t)item.font->glyphs->tileHeight );
+					drawText565( fb, *item.font, text, x, y, item.color );
+					break;
+				}
+			}
+		}
+	}
+
+	/**
+	 * Write a framebuffer to a binary PPM file
+	 */
+	boolean writePPM565( const Framebuffer& fb, const char* path ){
+		FILE* file = fopen( path, "wb" );
+		if (!file) return false;
+		fprintf( file, "P6\n%u %u\n255\n", fb.width, fb.height );
+		std::vector<uint8_t> row( fb.width * 3 );
+		boolean ok = true;
+		for (uint16_t y = 0; y < fb.height; y++){
+			const color565* src = fb.data + (uint32_t)y * fb.width;
+			for (uint16_t x = 0; x < fb.width; x++){
+				// Repeat the top bits in the new low bits, so that white stays white
+				uint8_t r = (src[x] >> 11) & 0x1F;
+				uint8_t g = (src[x] >> 5) & 0x3F;
+				uint8_t b = src[x] & 0x1F;
+				row[x * 3] = (r << 3) | (r >> 2);
+				row[x * 3 + 1] = (g << 2) | (g >> 4);
+				row[x * 3 + 2] = (b << 3) | (b >> 2);
+			}
+			if (fwrite( row.data(), 1, row.size(), file ) != row.size()) ok = false;
+		}
+		if (fclose( file )) ok = false;
+		return ok;
+	}
+
+	/**
+	 * Frame time at a percentile of the sorted times (nearest rank)
+	 */
+	static float percentile( const std::vector<float>& sorted, uint8_t p ){
+		if (sorted.empty()) return 0;
+		size_t rank = (sorted.size() * p + 99) / 100;
+		return sorted[ (rank > 0) ? rank - 1 : 0 ];
+	}
+
+	/**
+	 * Render frames of a scene, timing each one
+	 */
+	HeadlessResult headlessRun( Framebuffer& fb, const HeadlessScene& scene, uint32_t frames, Print* out, const char* capturePath, const uint32_t* captureFrames, uint16_t captureCount ){
+		HeadlessResult result;
+		std::vector<float> times;
+		times.reserve( frames );
+		result.captured = 0;
+		float total = 0;
+		for (uint32_t frame = 0; frame < frames; frame++){
+			auto start = std::chrono::steady_clock::now();
+			headlessRenderFrame( fb, scene, frame );
+			float us = std::chrono::duration<float, std::micro>( std::chrono::steady_clock::now() - start ).count();
+			times.push_back( us );
+			total += us;
+			if (!capturePath) continue;
+			for (uint16_t i = 0; i < captureCount; i++){
+				if (captureFrames[i] != frame) continue;
+				char path[256];
+				snprintf( path, sizeof(path), capturePath, (unsigned long)frame );
+				if (writePPM565( fb, path )) result.captured++;
+				break;
+			}
+		}
+		std::sort( times.begin(), times.end() );
+		result.frames = frames;
+		result.meanUs = frames ? total / frames : 0;
+		result.p50Us = percentile( times, 50 );
+		result.p90Us = percentile( times, 90 );
+		result.p99Us = percentile( times, 99 );
+		result.maxUs = times.empty() ? 0 : times.back();
+		if (out){
+			char line[160];
+			snprintf( line, sizeof(line), "%lu frames: mean %.1f us, p50 %.1f us, p90 %.1f us, p99 %.1f us, max %.1f us\n",
+				(unsigned long)result.frames, result.meanUs, result.p50Us, result.p90Us, result.p99Us, result.maxUs );
+			out->print( line );
+		}
+		return result;
+	}
+
+	#endif
+
+} // ns
@@ -0,0 +1,165 @@
+/**
+ * Headless host renderer for replaying scenes, capturing frames and timing them
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ *
+ * MIT LICENCE
+ * -----------
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef _MAC_HEADLESSH_
+#define _MAC_HEADLESSH_ 1
+
+#include "Bitmap.h"
+#include "Blit.h"
+#include "TileLayer.h"
+#include "Text.h"
+#include "Arena.h"
+#include "ImageLoader.h"
+
+/**
+ * Longest line of text in a headless scene, after formatting
+ **/
+#ifndef MAC_HEADLESS_TEXT
+	#define MAC_HEADLESS_TEXT 64
+#endif
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	#if MAC_HOST
+
+	/**
+	 * Kinds of item in a headless scene
+	 **/
+	typedef enum {
+		HL_LAYER			= 0,	// A tile layer that scrolls
+		HL_SPRITE			= 1,	// A tile that moves and optionally animates
+		HL_TEXT				= 2,	// A line of text that moves
+	} HeadlessItemType;
+
+	/**
+	 * An item in a headless scene. Items move in a straight line and bounce at the edges:
+	 * layers between the edges of their map, sprites and text between the edges of the
+	 * framebuffer. The position depends only on the frame number, so any frame can be
+	 * rendered on its own and every run renders the same pixels.
+	 **/
+	typedef struct HeadlessItemS {
+		HeadlessItemType type;				// What the item is
+		float x;							// Position at frame 0 (the scroll position for a layer)
+		float y;							// Position at frame 0
+		float vx;							// Pixels moved per frame
+		float vy;							// Pixels moved per frame
+		TileLayer* layer;					// HL_LAYER: the layer, which is scrolled
+		const Tilemap* tilemap;				// HL_SPRITE: the tiles
+		uint16_t tile;						// HL_SPRITE: the first tile
+		uint16_t tileCount;					// HL_SPRITE: number of animation frames (0 or 1 for none)
+		uint16_t frameTicks;				// HL_SPRITE: frames to show each animation frame for
+		const Font* font;					// HL_TEXT: the font
+		const char* text;					// HL_TEXT: the text, formatted with the frame number (e.g. "Frame %lu")
+		color565 color;						// HL_TEXT: the text color
+	} HeadlessItem;
+
+	/**
+	 * A scene to replay. Items are drawn in order, so the first is at the back.
+	 **/
+	typedef struct HeadlessSceneS {
+		const HeadlessItem* items;			// The items
+		uint16_t itemCount;					// Number of items
+		color565 background;				// Color the framebuffer is cleared to each frame
+	} HeadlessScene;
+
+	/**
+	 * Frame times of a headless run, in microseconds
+	 **/
+	typedef struct HeadlessResultS {
+		uint32_t frames;					// Number of frames rendered
+		float meanUs;						// Mean frame time
+		float p50Us;						// Median frame time
+		float p90Us;						// 90th percentile
+		float p99Us;						// 99th percentile
+		float maxUs;						// Slowest frame
+		uint16_t captured;					// Number of frames written to files
+	} HeadlessResult;
+
+	/**
+	 * Load a tilemap from a QOI file, for scenes that do not use generated headers
+	 * @param  tilemap 		(out) The tilemap
+	 * @param  arena 		Arena for the pixel data
+	 * @param  path 		Path of the file
+	 * @param  pf 			Pixel format to store the pixels in
+	 * @param  tileWidth 	Width of each tile (0 for the whole image)
+	 * @param  tileHeight 	Height of each tile (0 for the whole image)
+	 * @return         		IL_OK, or why the image could not be loaded
+	 */
+	ImageLoadError headlessLoadQoi( Tilemap& tilemap, Arena& arena, const char* path, PixelFormat pf, uint16_t tileWidth = 0, uint16_t tileHeight = 0 );
+
+	/**
+	 * Render one frame of a scene
+	 * @param fb 		The framebuffer to draw into
+	 * @param scene 	The scene
+	 * @param frame 	The frame number
+	 */
+	void headlessRenderFrame( Framebuffer& fb, const HeadlessScene& scene, uint32_t frame );
+
+	/**
+	 * Write a framebuffer to a binary PPM (P6) file
+	 * @param  fb 		The framebuffer
+	 * @param  path 	Path of the file
+	 * @return      	False if the file could not be written
+	 */
+	boolean writePPM565( const Framebuffer& fb, const char* path );
+
+	/**
+	 * Render frames 0 to frames-1 of a scene, timing each one. Captured frames are written
+	 * after they are timed, so writing them does not count.
+	 * @param  fb 				The framebuffer to draw into
+	 * @param  scene 			The scene
+	 * @param  frames 			Number of frames
+	 * @param  out 				Optional output to print a report to
+	 * @param  capturePath 		Path of captured frames, formatted with the frame number (e.g. "frame%04lu.ppm"), or 0
+	 * @param  captureFrames 	The frame numbers to capture
+	 * @param  captureCount 	Number of frames to capture
+	 * @return               	The frame times
+	 */
+	HeadlessResult headlessRun(
+		Framebuffer& fb,
+		const HeadlessScene& scene,
+		uint32_t frames,
+		Print* out = 0,
+		const char* capturePath = 0,
+		const uint32_t* captureFrames = 0,
+		uint16_t captureCount = 0
+	);
+
+	#endif
+
+} // ns
+
+#endif
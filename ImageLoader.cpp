@@ -0,0 +1,272 @@
+/**
+ * GUI library for "mac/μac"
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ **/
+
+#include "ImageLoader.h"
+#include "Trace.h"
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * QOI chunk tags
+	 **/
+	#define QOI_OP_INDEX	0x00
+	#define QOI_OP_DIFF		0x40
+	#define QOI_OP_LUMA		0x80
+	#define QOI_OP_RUN		0xC0
+	#define QOI_OP_RGB		0xFE
+	#define QOI_OP_RGBA		0xFF
+	#define QOI_MASK_2		0xC0
+
+	/**
+	 * Read callback for an image in memory
+	 */
+	uint32_t imageReadMemory( uint8_t* buffer, uint32_t size, void* data ){
+		ImageMemory& m = *(ImageMemory*)data;
+		uint32_t n = min( size, m.size - m.position );
+		memcpy( buffer, m.data + m.position, n );
+		m.position += n;
+		return n;
+	}
+
+	#if MAC_HOST
+	/**
+	 * Read callback for an image in an open file
+	 */
+	uint32_t imageReadFile( uint8_t* buffer, uint32_t size, void* data ){
+		return fread( buffer, 1, size, (FILE*)data );
+	}
+	#endif
+
+	/**
+	 * Get the next byte of the image. Returns 0 and sets IL_READ at the end of the data.
+	 */
+	static inline uint8_t nextByte( ImageLoader& loader ){
+		if (loader.chunkPos == loader.chunkLength){
+			loader.chunkPos = 0;
+			loader.chunkLength = loader.read( loader.chunk, MAC_IMAGE_CHUNK, loader.readData );
+			if (!loader.chunkLength){
+				loader.error = IL_READ;
+				return 0;
+			}
+		}
+		return loader.chunk[ loader.chunkPos++ ];
+	}
+
+	/**
+	 * Read a big-endian 32-bit value
+	 */
+	static uint32_t nextWord( ImageLoader& loader ){
+		uint32_t v = nextByte( loader ) << 24;
+		v |= nextByte( loader ) << 16;
+		v |= nextByte( loader ) << 8;
+		return v | nextByte( loader );
+	}
+
+	/**
+	 * Start loading an image and read its header
+	 */
+	boolean imageLoaderOpen( ImageLoader& loader, ImageReadCallback read, void* data ){
+		loader.read = read;
+		loader.readData = data;
+		loader.chunkPos = loader.chunkLength = 0;
+		loader.error = IL_OK;
+		uint32_t magic = nextWord( loader );
+		loader.width = nextWord( loader );
+		loader.height = nextWord( loader );
+		loader.channels = nextByte( loader );
+		nextByte( loader ); // Colorspace is not used
+		if (loader.error) return false;
+		if ((magic != 0x716F6966) || !loader.width || !loader.height || (loader.width > 0xFFFF) || (loader.height > 0xFFFF) || (loader.channels < 3) || (loader.channels > 4)){
+			loader.error = IL_FORMAT;
+			return false;
+		}
+		return true;
+	}
+
+	/**
+	 * Work out the tile layout of the open image
+	 */
+	static boolean tileLayout( const ImageLoader& loader, PixelFormat pixelFormat, uint16_t& tileWidth, uint16_t& tileHeight, ImageLoadError& error ){
+		if ((pixelFormat == mac::PF_INDEXED) || !pixelFormatByteWidth( pixelFormat )){
+			error = IL_PIXEL_FORMAT;
+			return false;
+		}
+		if (!tileWidth || !tileHeight){
+			tileWidth = loader.width;
+			tileHeight = loader.height;
+		}
+		if ((loader.width % tileWidth) || (loader.height % tileHeight)){
+			error = IL_TILE_SIZE;
+			return false;
+		}
+		return true;
+	}
+
+	/**
+	 * Get the memory needed to load the open image as a tilemap
+	 */
+	uint32_t imageLoaderSize( const ImageLoader& loader, PixelFormat pixelFormat, uint16_t tileWidth, uint16_t tileHeight ){
+		ImageLoadError error;
+		if (!tileLayout( loader, pixelFormat, tileWidth, tileHeight, error )) return 0;
+		return loader.width * loader.height * pixelFormatByteWidth( pixelFormat );
+	}
+
+	/**
+	 * Convert a RGBA pixel to the bytes of a pixel format, as stored in assets
+	 */
+	static inline void storePixel( uint8_t* out, PixelFormat pixelFormat, uint8_t r, uint8_t g, uint8_t b, uint8_t a ){
+		uint32_t p;
+		switch (pixelFormat){
+			case mac::PF_565:
+				p = (a < 128) ? RGB565_Transparent : (((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3));
+				out[0] = p >> 8; out[1] = p;
+				break;
+			case mac::PF_4444:
+				p = ((a & 0xF0) << 8) | ((r & 0xF0) << 4) | (g & 0xF0) | (b >> 4);
+				out[0] = p >> 8; out[1] = p;
+				break;
+			case mac::PF_6666:
+				p = ((a >> 2) << 18) | ((r >> 2) << 12) | ((g >> 2) << 6) | (b >> 2);
+				out[0] = p >> 16; out[1] = p >> 8; out[2] = p;
+				break;
+			case mac::PF_8565:
+				p = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+				out[0] = a; out[1] = p >> 8; out[2] = p;
+				break;
+			case mac::PF_888:
+				p = (a < 128) ? RGB888_Transparent : ((r << 16) | (g << 8) | b);
+				out[0] = p >> 16; out[1] = p >> 8; out[2] = p;
+				break;
+			case mac::PF_8888:
+				out[0] = a; out[1] = r; out[2] = g; out[3] = b;
+				break;
+			case mac::PF_GRAYSCALE:
+				out[0] = (r * 77 + g * 150 + b * 29) >> 8;
+				break;
+			default:
+				break;
+		}
+	}
+
+	/**
+	 * Decode the open image into memory as a tilemap
+	 */
+	boolean imageLoaderDecode( ImageLoader& loader, Tilemap& tilemap, PixelFormat pixelFormat, uint16_t tileWidth, uint16_t tileHeight, uint8_t* memory ){
+		MAC_TRACE_SCOPE( "imageLoad" );
+		if (!tileLayout( loader, pixelFormat, tileWidth, tileHeight, loader.error )) return false;
+		uint8_t bpp = pixelFormatByteWidth( pixelFormat );
+		uint32_t cols = loader.width / tileWidth;
+		uint32_t stride = tileWidth * tileHeight * bpp;
+
+		uint8_t index[64][4];
+		memset( index, 0, sizeof(index) );
+		uint8_t r = 0, g = 0, b = 0, a = 255;
+		uint8_t px[4];
+		storePixel( px, pixelFormat, r, g, b, a );
+		uint8_t run = 0;
+
+		for (uint32_t y = 0; y < loader.height; y++){
+			uint8_t* rowStart = memory + (y / tileHeight) * cols * stride + (y % tileHeight) * tileWidth * bpp;
+			uint8_t* out = rowStart;
+			uint16_t tx = 0;
+			for (uint32_t x = 0; x < loader.width; x++){
+				if (run) run--;
+				else {
+					uint8_t op = nextByte( loader );
+					if (op == QOI_OP_RGB){
+						r = nextByte( loader );
+						g = nextByte( loader );
+						b = nextByte( loader );
+					}
+					else if (op == QOI_OP_RGBA){
+						r = nextByte( loader );
+						g = nextByte( loader );
+						b = nextByte( loader );
+						a = nextByte( loader );
+					}
+					else if ((op & QOI_MASK_2) == QOI_OP_INDEX){
+						r = index[op][0];
+						g = index[op][1];
+						b = index[op][2];
+						a = index[op][3];
+					}
+					else if ((op & QOI_MASK_2) == QOI_OP_DIFF){
+						r += ((op >> 4) & 3) - 2;
+						g += ((op >> 2) & 3) - 2;
+						b += (op & 3) - 2;
+					}
+					else if ((op & QOI_MASK_2) == QOI_OP_LUMA){
+						uint8_t d = nextByte( loader );
+						int8_t dg = (op & 0x3F) - 32;
+						r += dg - 8 + (d >> 4);
+						g += dg;
+						b += dg - 8 + (d & 15);
+					}
+					else run = op & 0x3F;
+					if (loader.error) return false;
+					uint8_t* slot = index[ (r * 3 + g * 5 + b * 7 + a * 11) & 63 ];
+					slot[0] = r; slot[1] = g; slot[2] = b; slot[3] = a;
+					storePixel( px, pixelFormat, r, g, b, a );
+				}
+				for (uint8_t i = 0; i < bpp; i++) *out++ = px[i];
+
+				// Move to the same row of the next tile
+				if (++tx == tileWidth){
+					tx = 0;
+					out += stride - tileWidth * bpp;
+				}
+			}
+		}
+
+		tilemap.pixelFormat = pixelFormat;
+		tilemap.transparentColor = (pixelFormat == mac::PF_565) ? (uint32_t)RGB565_Transparent : ((pixelFormat == mac::PF_888) ? (uint32_t)RGB888_Transparent : 0);
+		tilemap.dataSize = loader.width * loader.height * bpp;
+		tilemap.data = memory;
+		tilemap.tileWidth = tileWidth;
+		tilemap.tileHeight = tileHeight;
+		tilemap.tileCount = cols * (loader.height / tileHeight);
+		tilemap.tileStride = stride;
+		return true;
+	}
+
+	/**
+	 * Load a QOI image as a tilemap with pixel memory from an arena
+	 */
+	ImageLoadError imageLoadQoi(
+		Tilemap& tilemap,
+		Arena& arena,
+		ImageReadCallback read,
+		void* data,
+		PixelFormat pixelFormat,
+		uint16_t tileWidth,
+		uint16_t tileHeight,
+		MemoryHint hint
+	){
+		ImageLoader loader;
+		if (!imageLoaderOpen( loader, read, data )) return loader.error;
+		uint32_t size = imageLoaderSize( loader, pixelFormat, tileWidth, tileHeight );
+		if (!size){
+			tileLayout( loader, pixelFormat, tileWidth, tileHeight, loader.error );
+			return loader.error;
+		}
+		ArenaMark mark = arenaMark( arena );
+		uint8_t* memory = (uint8_t*)arenaAlloc( arena, size, hint );
+		if (!memory) return IL_MEMORY;
+		if (!imageLoaderDecode( loader, tilemap, pixelFormat, tileWidth, tileHeight, memory )){
+			arenaRelease( arena, mark );
+			return loader.error;
+		}
+		return IL_OK;
+	}
+
+} // ns
@@ -0,0 +1,172 @@
+/**
+ * Streaming image loader for runtime assets
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ *
+ * MIT LICENCE
+ * -----------
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef _MAC_IMAGELOADERH_
+#define _MAC_IMAGELOADERH_ 1
+
+#include "Bitmap.h"
+#include "Arena.h"
+
+#if MAC_HOST
+	#include <stdio.h>
+#endif
+
+/**
+ * Size of the read buffer in an ImageLoader, in bytes
+ **/
+#ifndef MAC_IMAGE_CHUNK
+	#define MAC_IMAGE_CHUNK 256
+#endif
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * Why loading an image failed
+	 **/
+	typedef enum {
+		IL_OK				= 0,	// No error
+		IL_READ				= 1,	// The data ended early
+		IL_FORMAT			= 2,	// Not a supported image
+		IL_PIXEL_FORMAT		= 3,	// The pixel format cannot be loaded into (PF_INDEXED, PF_MONO)
+		IL_TILE_SIZE		= 4,	// The image is not a whole number of tiles
+		IL_MEMORY			= 5		// Not enough memory for the pixels
+	} ImageLoadError;
+
+	/**
+	 * Reads the next bytes of an image (from a file, SD card, network buffer etc)
+	 * @param  buffer 	Where to put the bytes
+	 * @param  size 	The most bytes to read
+	 * @param  data 	User data
+	 * @return        	The number of bytes read (0 at the end of the data)
+	 */
+	typedef uint32_t (*ImageReadCallback)( uint8_t* buffer, uint32_t size, void* data );
+
+	/**
+	 * Decodes a QOI image (https://qoiformat.org) as it is read. Only the small read buffer
+	 * and the QOI color index are held, never the whole RGBA image.
+	 **/
+	typedef struct ImageLoaderS {
+		ImageReadCallback read;				// Reads the image
+		void* readData;						// User data for read
+		uint8_t chunk[ MAC_IMAGE_CHUNK ];	// The read buffer
+		uint16_t chunkPos;					// Next byte in the read buffer
+		uint16_t chunkLength;				// Number of bytes in the read buffer
+		uint32_t width;						// Width of the image
+		uint32_t height;					// Height of the image
+		uint8_t channels;					// 3 (RGB) or 4 (RGBA)
+		ImageLoadError error;				// Why the last step failed
+	} ImageLoader;
+
+	/**
+	 * A block of memory to read an image from, for imageReadMemory
+	 **/
+	typedef struct ImageMemoryS {
+		const uint8_t* data;				// The image file
+		uint32_t size;						// Size in bytes
+		uint32_t position;					// Next byte to read
+	} ImageMemory;
+
+	/**
+	 * Read callback for an image in memory. Pass an ImageMemory as the data.
+	 */
+	uint32_t imageReadMemory( uint8_t* buffer, uint32_t size, void* data );
+
+	#if MAC_HOST
+	/**
+	 * Read callback for an image in an open file. Pass the FILE* as the data.
+	 */
+	uint32_t imageReadFile( uint8_t* buffer, uint32_t size, void* data );
+	#endif
+
+	/**
+	 * Start loading an image and read its header
+	 * @param  loader 	The loader
+	 * @param  read 	Reads the image
+	 * @param  data 	User data for read
+	 * @return      	False if the header could not be read or is not a QOI image
+	 */
+	boolean imageLoaderOpen( ImageLoader& loader, ImageReadCallback read, void* data = 0 );
+
+	/**
+	 * Get the memory needed to load the open image as a tilemap
+	 * @param  loader 		The loader
+	 * @param  pixelFormat 	The pixel format to convert to
+	 * @param  tileWidth 	Width of each tile (0 for the whole image as one tile)
+	 * @param  tileHeight 	Height of each tile (0 for the whole image as one tile)
+	 * @return             	Bytes needed, or 0 if the format or tile size cannot be used
+	 */
+	uint32_t imageLoaderSize( const ImageLoader& loader, PixelFormat pixelFormat, uint16_t tileWidth = 0, uint16_t tileHeight = 0 );
+
+	/**
+	 * Decode the open image into memory as a tilemap, converting each pixel to the pixel
+	 * format and slicing the image into tiles (like the t- option of tilemap_to_h.py). For
+	 * PF_565 and PF_888, pixels less than half opaque become the transparent color.
+	 * @param  loader 		The loader
+	 * @param  tilemap 		(out) The tilemap. Its data points into memory.
+	 * @param  pixelFormat 	The pixel format to convert to
+	 * @param  tileWidth 	Width of each tile (0 for the whole image as one tile)
+	 * @param  tileHeight 	Height of each tile (0 for the whole image as one tile)
+	 * @param  memory 		Memory for the pixels (see imageLoaderSize)
+	 * @return 				False on error (see loader.error)
+	 */
+	boolean imageLoaderDecode( ImageLoader& loader, Tilemap& tilemap, PixelFormat pixelFormat, uint16_t tileWidth, uint16_t tileHeight, uint8_t* memory );
+
+	/**
+	 * Load a QOI image as a tilemap with pixel memory from an arena
+	 * @param  tilemap 		(out) The tilemap
+	 * @param  arena 		The arena
+	 * @param  read 		Reads the image
+	 * @param  data 		User data for read
+	 * @param  pixelFormat 	The pixel format to convert to
+	 * @param  tileWidth 	Width of each tile (0 for the whole image as one tile)
+	 * @param  tileHeight 	Height of each tile (0 for the whole image as one tile)
+	 * @param  hint 		Where the memory should come from
+	 * @return 				IL_OK, or why it failed
+	 */
+	ImageLoadError imageLoadQoi(
+		Tilemap& tilemap,
+		Arena& arena,
+		ImageReadCallback read,
+		void* data,
+		PixelFormat pixelFormat,
+		uint16_t tileWidth = 0,
+		uint16_t tileHeight = 0,
+		MemoryHint hint = MR_SLOW
+	);
+
+} // ns
+
+#endif
@@ -0,0 +1,145 @@
+/**
+ * GUI library for "mac/μac"
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ **/
+
+#include "Mipmap.h"
+#include "RenderStats.h"
+#include "Trace.h"
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * Draw one tile of a level into a destination rectangle of any size up to the level's
+	 * tile size. Pixels are picked from the centre of each destination pixel's footprint.
+	 */
+	static boolean drawTileSized565(
+		Framebuffer& fb,
+		const Tilemap& tilemap,
+		uint16_t index,
+		const Rect& dest,
+		const Rect& area,
+		const ColorRemap* remap,
+		const BlitEffects* fx
+	){
+		Rect part;
+		if ((index >= tilemap.tileCount) || !rectIntersect( area, dest, part )){
+			MAC_STAT_ADD( tilesCulled, 1 );
+			return false;
+		}
+		MAC_STAT_ADD( tilesDrawn, 1 );
+
+		uint8_t bpp = pixelFormatByteWidth( tilemap.pixelFormat );
+		uint32_t lw = tilemap.tileWidth;
+		uint32_t lh = tilemap.tileHeight;
+		const uint8_t* tile = tilemap.data + tilemap.tileStride * index;
+		uint16_t offsets[ MAC_MIP_SPAN ];
+		uint8_t line[ MAC_MIP_SPAN * 4 ];
+
+		for (int16_t x0 = part.x; x0 < part.x + part.w; x0 += MAC_MIP_SPAN){
+			uint16_t count = min( (int32_t)MAC_MIP_SPAN, (int32_t)(part.x + part.w - x0) );
+			for (uint16_t i = 0; i < count; i++){
+				uint32_t dx = x0 + i - dest.x;
+				offsets[i] = ((2 * dx + 1) * lw / (2 * dest.w)) * bpp;
+			}
+			for (int16_t y = part.y; y < part.y + part.h; y++){
+				uint32_t dy = y - dest.y;
+				const uint8_t* src = tile + ((2 * dy + 1) * lh / (2 * dest.h)) * lw * bpp;
+				uint8_t* p = line;
+				for (uint16_t i = 0; i < count; i++){
+					const uint8_t* s = src + offsets[i];
+					for (uint8_t b = 0; b < bpp; b++) *p++ = s[b];
+				}
+				blitSpan565( line, tilemap.pixelFormat, tilemap.transparentColor, fb.data + y * fb.width + x0, count, remap, fx );
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * Scale a full size layer position to framebuffer pixels, rounding down
+	 */
+	static inline int32_t scaleEdge( int32_t position, uint16_t scale ){
+		int64_t p = (int64_t)position * scale;
+		return (int32_t)((p >= 0) ? (p >> 8) : -((255 - p) >> 8));
+	}
+
+	/**
+	 * Draw a tile at a reduced scale into a framebuffer
+	 */
+	boolean drawTileScaled565(
+		Framebuffer& fb,
+		const TileMips& mips,
+		uint16_t index,
+		int16_t x,
+		int16_t y,
+		uint16_t scale,
+		const Rect* clip,
+		const ColorRemap* remap,
+		const BlitEffects* fx
+	){
+		MAC_STAT_TIMER( RS_BLIT );
+		MAC_TRACE_SCOPE( "blitScaled" );
+		if (!mips.levels[0] || !scale) return false;
+		scale = min( scale, (uint16_t)256 );
+		Rect area = framebufferRect( fb );
+		if (clip && !rectIntersect( area, *clip, area )) return false;
+		Rect dest = {
+			x, y,
+			(int16_t)scaleEdge( mips.levels[0]->tileWidth, scale ),
+			(int16_t)scaleEdge( mips.levels[0]->tileHeight, scale )
+		};
+		if ((dest.w <= 0) || (dest.h <= 0)) return false;
+		return drawTileSized565( fb, *mips.levels[ tileMipLevel( mips, scale ) ], index, dest, area, remap, fx );
+	}
+
+	/**
+	 * Render a tile layer at a reduced scale
+	 */
+	void renderTileLayerScaled565( Framebuffer& fb, const TileLayer& layer, const TileMips& mips, uint16_t scale, const Rect* clip ){
+		MAC_STAT_TIMER( RS_TILE_LAYER );
+		MAC_TRACE_SCOPE( "tileLayerScaled" );
+		if (!mips.levels[0] || !layer.map || !scale) return;
+		scale = min( scale, (uint16_t)256 );
+		Rect area = framebufferRect( fb );
+		if (clip && !rectIntersect( area, *clip, area )) return;
+
+		const Tilemap& tilemap = *mips.levels[ tileMipLevel( mips, scale ) ];
+		int32_t tw = mips.levels[0]->tileWidth;
+		int32_t th = mips.levels[0]->tileHeight;
+		if (!tw || !th) return;
+
+		// The cells that touch the clip area, in full size layer pixels
+		int32_t col0 = floorDiv( layer.scrollX + floorDiv( area.x * 256, scale ), tw );
+		int32_t row0 = floorDiv( layer.scrollY + floorDiv( area.y * 256, scale ), th );
+		int32_t col1 = floorDiv( layer.scrollX + floorDiv( (area.x + area.w) * 256, scale ), tw );
+		int32_t row1 = floorDiv( layer.scrollY + floorDiv( (area.y + area.h) * 256, scale ), th );
+
+		// Each cell spans from its own scaled edge to the next one, so there are no gaps
+		int32_t originX = scaleEdge( layer.scrollX, scale );
+		int32_t originY = scaleEdge( layer.scrollY, scale );
+		for (int32_t row = row0; row <= row1; row++){
+			int32_t y0 = scaleEdge( row * th, scale ) - originY;
+			int32_t y1 = scaleEdge( (row + 1) * th, scale ) - originY;
+			if (y1 <= y0) continue;
+			for (int32_t col = col0; col <= col1; col++){
+				uint16_t index = tileLayerTile( layer, col, row );
+				if (index == TILE_NONE) continue;
+				int32_t x0 = scaleEdge( col * tw, scale ) - originX;
+				int32_t x1 = scaleEdge( (col + 1) * tw, scale ) - originX;
+				if (x1 <= x0) continue;
+				Rect dest = { (int16_t)x0, (int16_t)y0, (int16_t)(x1 - x0), (int16_t)(y1 - y0) };
+				drawTileSized565( fb, tilemap, index, dest, area, 0, 0 );
+			}
+		}
+	}
+
+} // ns
@@ -0,0 +1,118 @@
+/**
+ * Pre-downscaled tile levels for drawing tilemaps at a reduced scale
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ *
+ * MIT LICENCE
+ * -----------
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef _MAC_MIPMAPH_
+#define _MAC_MIPMAPH_ 1
+
+#include "Bitmap.h"
+#include "Blit.h"
+#include "TileLayer.h"
+
+/**
+ * Largest scaled tile width drawn in one span. Wider tiles are drawn in several spans.
+ **/
+#ifndef MAC_MIP_SPAN
+	#define MAC_MIP_SPAN 128
+#endif
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * Number of levels in a TileMips
+	 **/
+	const uint8_t MIP_LEVELS = 3;
+
+	/**
+	 * A tilemap and its pre-downscaled levels. Level 0 is full size, level 1 is half size
+	 * and level 2 is quarter size. Every level has the same tiles in the same order.
+	 * Missing levels are 0. tilemap_to_h.py outputs these with the m- option.
+	 **/
+	typedef struct TileMipsS {
+		const Tilemap* levels[ MIP_LEVELS ];	// The levels, largest first
+	} TileMips;
+
+	/**
+	 * Pick the smallest level that still has at least as many pixels as are drawn
+	 * @param  mips 	The levels
+	 * @param  scale 	The scale to draw at, out of 256 (256 is full size)
+	 * @return       	The level
+	 */
+	inline uint8_t tileMipLevel( const TileMips& mips, uint16_t scale ){
+		uint8_t level = 0;
+		while ((level + 1 < MIP_LEVELS) && mips.levels[ level + 1 ] && (scale <= (256 >> (level + 1)))) level++;
+		return level;
+	}
+
+	/**
+	 * Draw a tile at a reduced scale into a framebuffer, from the best level
+	 * @param  fb 		The framebuffer to draw into
+	 * @param  mips 	The tile levels
+	 * @param  index 	The tile index
+	 * @param  x 		Destination x
+	 * @param  y 		Destination y
+	 * @param  scale 	The scale, out of 256 (1 to 256)
+	 * @param  clip 	Optional clip rectangle (in addition to the framebuffer bounds)
+	 * @param  remap 	Optional color remap
+	 * @param  fx 		Optional color effects
+	 * @return 			False if nothing was drawn
+	 */
+	boolean drawTileScaled565(
+		Framebuffer& fb,
+		const TileMips& mips,
+		uint16_t index,
+		int16_t x,
+		int16_t y,
+		uint16_t scale,
+		const Rect* clip = 0,
+		const ColorRemap* remap = 0,
+		const BlitEffects* fx = 0
+	);
+
+	/**
+	 * Render a tile layer at a reduced scale, for zoomed-out overview maps. The tiles come
+	 * from the best level of mips instead of the layer's tilemap, and the layer's scroll
+	 * position is in full size pixels. Tile edges are rounded so that there are no gaps.
+	 * @param fb 		The framebuffer to draw into
+	 * @param layer 	The tile layer
+	 * @param mips 		The tile levels (level 0 must match the layer's tilemap)
+	 * @param scale 	The scale, out of 256 (1 to 256)
+	 * @param clip 		Optional clip rectangle (in addition to the framebuffer bounds)
+	 */
+	void renderTileLayerScaled565( Framebuffer& fb, const TileLayer& layer, const TileMips& mips, uint16_t scale, const Rect* clip = 0 );
+
+} // ns
+
+#endif
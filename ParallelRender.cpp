@@ -0,0 +1,245 @@
+/**
+ * GUI library for "mac/μac"
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ **/
+
+#include "ParallelRender.h"
+#include "Trace.h"
+
+#if MAC_HOST
+
+#include <chrono>
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * Create a render pool
+	 */
+	RenderPool::RenderPool( uint8_t threads ){
+		if (!threads){
+			uint32_t cores = std::thread::hardware_concurrency();
+			threads = (cores == 0) ? 1 : (cores > 255) ? 255 : cores;
+		}
+		_threadCount = threads;
+		_partition = RP_BANDS;
+		_tilesPerJob = 1;
+		_fb = 0;
+		_layers = 0;
+		_layerCount = 0;
+		_generation = 0;
+		_stop = false;
+		_remaining = 0;
+		_steals = 0;
+		for (uint8_t i = 0; i < _threadCount; i++){
+			_queues.push_back( std::unique_ptr<WorkQueue>( new WorkQueue() ) );
+		}
+		// Worker 0 is the calling thread
+		for (uint8_t i = 1; i < _threadCount; i++){
+			_threads.push_back( std::thread( &RenderPool::workerLoop, this, i ) );
+		}
+	}
+
+	RenderPool::~RenderPool(){
+		{
+			std::lock_guard<std::mutex> guard( _lock );
+			_stop = true;
+		}
+		_wake.notify_all();
+		for (std::thread& t : _threads) t.join();
+	}
+
+	/**
+	 * Set how the framebuffer is split into jobs
+	 */
+	void RenderPool::setPartition( RenderPartition partition, uint16_t tilesPerJob ){
+		_partition = partition;
+		_tilesPerJob = tilesPerJob ? tilesPerJob : 1;
+	}
+
+	/**
+	 * Split the area into jobs along the tile edges of the first layer
+	 */
+	void RenderPool::partition( const Rect& area, const TileLayer* layers ){
+		_jobs.clear();
+		int32_t tw = 16, th = 16, sx = 0, sy = 0;
+		if (layers[0].tilemap && layers[0].tilemap->tileWidth && layers[0].tilemap->tileHeight){
+			tw = layers[0].tilemap->tileWidth;
+			th = layers[0].tilemap->tileHeight;
+			sx = layers[0].scrollX;
+			sy = layers[0].scrollY;
+		}
+		int32_t jobH = th * _tilesPerJob;
+		int32_t jobW = (_partition == RP_BLOCKS) ? tw * _tilesPerJob : area.w;
+
+		// Start each job edge on the tile grid, so the first job may be smaller
+		int32_t y = area.y;
+		int32_t yEdge = area.y - (sy + area.y - floorDiv( sy + area.y, th ) * th);
+		while (y < area.y + area.h){
+			int32_t y1 = min( yEdge + jobH, (int32_t)(area.y + area.h) );
+			int32_t x = area.x;
+			int32_t xEdge = (_partition == RP_BLOCKS) ? area.x - (sx + area.x - floorDiv( sx + area.x, tw ) * tw) : area.x;
+			while (x < area.x + area.w){
+				int32_t x1 = min( xEdge + jobW, (int32_t)(area.x + area.w) );
+				_jobs.push_back( { (int16_t)x, (int16_t)y, (int16_t)(x1 - x), (int16_t)(y1 - y) } );
+				x = xEdge = x1;
+			}
+			y = yEdge = y1;
+		}
+	}
+
+	/**
+	 * Take the next job from our own queue, or steal one from the back of another queue
+	 */
+	boolean RenderPool::takeJob( uint8_t worker, uint32_t& job ){
+		{
+			WorkQueue& own = *_queues[worker];
+			std::lock_guard<std::mutex> guard( own.lock );
+			if (!own.jobs.empty()){
+				job = own.jobs.front();
+				own.jobs.pop_front();
+				return true;
+			}
+		}
+		for (uint8_t i = 1; i < _threadCount; i++){
+			WorkQueue& victim = *_queues[(worker + i) % _threadCount];
+			std::lock_guard<std::mutex> guard( victim.lock );
+			if (!victim.jobs.empty()){
+				job = victim.jobs.back();
+				victim.jobs.pop_back();
+				_steals++;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/**
+	 * Render jobs until there are none left to take
+	 */
+	void RenderPool::runJobs( uint8_t worker ){
+		uint32_t job;
+		while (takeJob( worker, job )){
+			MAC_TRACE_SCOPE( "job" );
+			const Rect& area = _jobs[job];
+			for (uint8_t i = 0; i < _layerCount; i++){
+				mac::renderTileLayer565( *_fb, _layers[i], &area );
+			}
+			if (--_remaining == 0){
+				std::lock_guard<std::mutex> guard( _lock );
+				_done.notify_all();
+			}
+		}
+	}
+
+	/**
+	 * Background threads sleep until a frame starts, then help render it
+	 */
+	void RenderPool::workerLoop( uint8_t worker ){
+		uint32_t seen = 0;
+		while (true){
+			{
+				std::unique_lock<std::mutex> guard( _lock );
+				_wake.wait( guard, [&]{ return _stop || (_generation != seen); } );
+				if (_stop) return;
+				seen = _generation;
+			}
+			runJobs( worker );
+		}
+	}
+
+	/**
+	 * Render tile layers into the framebuffer
+	 */
+	void RenderPool::renderTileLayers565( Framebuffer& fb, const TileLayer* layers, uint8_t layerCount, const Rect* clip ){
+		MAC_TRACE_SCOPE( "renderPool" );
+		Rect area = framebufferRect( fb );
+		if (clip && !rectIntersect( area, *clip, area )) return;
+		if (!layerCount) return;
+
+		partition( area, layers );
+		if (_jobs.empty()) return;
+		_fb = &fb;
+		_layers = layers;
+		_layerCount = layerCount;
+		_remaining = _jobs.size();
+
+		// Deal out neighbouring jobs to the same thread for locality
+		size_t jobCount = _jobs.size();
+		for (size_t i = 0; i < jobCount; i++){
+			WorkQueue& queue = *_queues[i * _threadCount / jobCount];
+			std::lock_guard<std::mutex> guard( queue.lock );
+			queue.jobs.push_back( i );
+		}
+		{
+			std::lock_guard<std::mutex> guard( _lock );
+			_generation++;
+		}
+		_wake.notify_all();
+
+		runJobs( 0 );
+		std::unique_lock<std::mutex> guard( _lock );
+		_done.wait( guard, [&]{ return _remaining == 0; } );
+	}
+
+	/**
+	 * Render all layers for a number of frames and return the average time per frame
+	 */
+	static float timeFrames( Framebuffer& fb, const TileLayer* layers, uint8_t layerCount, uint16_t frames, RenderPool* pool ){
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (uint16_t f = 0; f < frames; f++){
+			memset( fb.data, 0, fb.width * fb.height * sizeof(color565) );
+			if (pool) pool->renderTileLayers565( fb, layers, layerCount );
+			else for (uint8_t i = 0; i < layerCount; i++) renderTileLayer565( fb, layers[i] );
+		}
+		std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		return frames ? elapsed.count() / frames : 0;
+	}
+
+	/**
+	 * Benchmark the render pool from 1 to maxThreads threads
+	 */
+	uint8_t benchmarkRenderPool(
+		Framebuffer& fb,
+		const TileLayer* layers,
+		uint8_t layerCount,
+		uint8_t maxThreads,
+		uint16_t frames,
+		RenderPoolBenchmark* results,
+		Print* out
+	){
+		size_t pixels = fb.width * fb.height;
+		std::vector<color565> reference( pixels );
+
+		// Serial reference frame
+		timeFrames( fb, layers, layerCount, 1, 0 );
+		memcpy( reference.data(), fb.data, pixels * sizeof(color565) );
+
+		char line[80];
+		if (out) out->print( "threads   ms/frame   speedup   identical\n" );
+		for (uint8_t t = 1; t <= maxThreads; t++){
+			RenderPool pool( t );
+			RenderPoolBenchmark& r = results[t - 1];
+			r.threads = t;
+			timeFrames( fb, layers, layerCount, 1, &pool ); // warm up
+			r.msPerFrame = timeFrames( fb, layers, layerCount, frames, &pool );
+			r.speedup = (r.msPerFrame > 0) ? results[0].msPerFrame / r.msPerFrame : 0;
+			r.identical = memcmp( reference.data(), fb.data, pixels * sizeof(color565) ) == 0;
+			if (out){
+				snprintf( line, sizeof(line), "%7u   %8.3f   %6.2fx   %s\n", t, r.msPerFrame, r.speedup, r.identical ? "yes" : "NO" );
+				out->print( line );
+			}
+		}
+		return maxThreads;
+	}
+
+} // ns
+
+#endif
@@ -0,0 +1,184 @@
+/**
+ * Multi-threaded tile layer rendering for host builds
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ *
+ * MIT LICENCE
+ * -----------
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef _MAC_PARALLELRENDERH_
+#define _MAC_PARALLELRENDERH_ 1
+
+#include "Bitmap.h"
+#include "TileLayer.h"
+
+#if MAC_HOST
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * How the framebuffer is split into jobs for the render pool. Job edges always fall on
+	 * tile edges of the first layer, so no tile of that layer is split between two jobs.
+	 **/
+	typedef enum {
+		RP_BANDS			= 0,	// Full-width horizontal bands, tilesPerJob tile rows high
+		RP_BLOCKS			= 1		// Blocks of tilesPerJob x tilesPerJob tiles
+	} RenderPartition;
+
+	/**
+	 * Result of one step of the render pool benchmark
+	 **/
+	typedef struct RenderPoolBenchmarkS {
+		uint8_t threads;					// Number of threads used
+		float msPerFrame;					// Average time to render a frame, in milliseconds
+		float speedup;						// Speed relative to the single thread run
+		boolean identical;					// True if the output matched the serial path bit for bit
+	} RenderPoolBenchmark;
+
+	/**
+	 * A pool of threads that render tile layers in parallel. The framebuffer is split into
+	 * jobs (bands or blocks) which are dealt out to per-thread queues. A thread that runs out
+	 * of work steals jobs from the back of another thread's queue. Each job renders every
+	 * layer, in order, clipped to its own rectangle, and no two jobs share a pixel, so the
+	 * output is bit-identical to calling renderTileLayer565 for each layer in turn.
+	 * The calling thread also works, so a pool of 1 thread renders serially.
+	 **/
+	class RenderPool {
+		public:
+			/**
+			 * Create a render pool
+			 * @param threads 	Total number of threads including the caller. 0 to use one per core.
+			 */
+			RenderPool( uint8_t threads = 0 );
+			~RenderPool();
+
+			/**
+			 * Set how the framebuffer is split into jobs. The default is RP_BANDS, 1 tile high.
+			 * @param partition 	Bands or blocks
+			 * @param tilesPerJob 	Size of each job in tiles of the first layer
+			 */
+			void setPartition( RenderPartition partition, uint16_t tilesPerJob );
+
+			/**
+			 * Render tile layers into the framebuffer, back to front. Returns when the frame is done.
+			 * @param fb 			The framebuffer to draw into
+			 * @param layers 		The tile layers, back to front
+			 * @param layerCount 	The number of layers
+			 * @param clip 			Optional clip rectangle (in addition to the framebuffer bounds)
+			 */
+			void renderTileLayers565( Framebuffer& fb, const TileLayer* layers, uint8_t layerCount, const Rect* clip = 0 );
+
+			/**
+			 * Render a single tile layer into the framebuffer
+			 * @see renderTileLayers565
+			 */
+			void renderTileLayer565( Framebuffer& fb, const TileLayer& layer, const Rect* clip = 0 ){
+				renderTileLayers565( fb, &layer, 1, clip );
+			}
+
+			/**
+			 * The total number of threads, including the caller
+			 */
+			uint8_t threadCount() const { return _threadCount; }
+
+			/**
+			 * The number of jobs taken from another thread's queue since the pool was created
+			 */
+			uint32_t stealCount() const { return _steals; }
+
+		private:
+			typedef struct WorkQueueS {
+				std::mutex lock;
+				std::deque<uint32_t> jobs;
+			} WorkQueue;
+
+			void partition( const Rect& area, const TileLayer* layers );
+			boolean takeJob( uint8_t worker, uint32_t& job );
+			void runJobs( uint8_t worker );
+			void workerLoop( uint8_t worker );
+
+			uint8_t _threadCount;
+			RenderPartition _partition;
+			uint16_t _tilesPerJob;
+			std::vector<std::thread> _threads;
+			std::vector<std::unique_ptr<WorkQueue>> _queues;
+			std::vector<Rect> _jobs;
+
+			// Current frame
+			Framebuffer* _fb;
+			const TileLayer* _layers;
+			uint8_t _layerCount;
+
+			std::mutex _lock;
+			std::condition_variable _wake;
+			std::condition_variable _done;
+			uint32_t _generation;
+			boolean _stop;
+			std::atomic<uint32_t> _remaining;
+			std::atomic<uint32_t> _steals;
+	};
+
+	/**
+	 * Benchmark the render pool from 1 to maxThreads threads. Each step renders the layers
+	 * for a number of frames (clearing the framebuffer first) and compares the result with
+	 * the serial path.
+	 * @param  fb 			The framebuffer to draw into
+	 * @param  layers 		The tile layers, back to front
+	 * @param  layerCount 	The number of layers
+	 * @param  maxThreads 	The highest number of threads to try
+	 * @param  frames 		The number of frames to render at each step
+	 * @param  results 		(out) One result per step. Must have room for maxThreads results.
+	 * @param  out 			Optional output to print a report to
+	 * @return            	The number of results written
+	 */
+	uint8_t benchmarkRenderPool(
+		Framebuffer& fb,
+		const TileLayer* layers,
+		uint8_t layerCount,
+		uint8_t maxThreads,
+		uint16_t frames,
+		RenderPoolBenchmark* results,
+		Print* out = 0
+	);
+
+} // ns
+
+#endif
+
+#endif
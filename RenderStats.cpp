@@ -0,0 +1,152 @@
+/**
+ * GUI library for "mac/μac"
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ **/
+
+#include "RenderStats.h"
+
+#if MAC_RENDER_STATS && MAC_HOST
+	#include <mutex>
+#endif
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	#if MAC_RENDER_STATS
+
+	static RenderStats lastFrame;
+
+	#if MAC_HOST
+		/**
+		 * The counters of one thread. Each thread's counters are in a list so that
+		 * renderStatsEndFrame can add them up. When a thread exits, its counts are kept in
+		 * statsRetired so they still count towards the frame.
+		 */
+		class RenderStatsThread {
+			public:
+				RenderStatsThread();
+				~RenderStatsThread();
+				RenderStats stats;
+				RenderStatsThread* next;
+		};
+
+		static std::mutex statsLock;
+		static RenderStatsThread* statsThreads = 0;
+		static RenderStats statsRetired;
+
+		/**
+		 * Add the counts of one set of statistics to another
+		 */
+		static void addStats( RenderStats& to, const RenderStats& from ){
+			for (uint8_t i = 0; i < 10; i++) to.converted[i] += from.converted[i];
+			to.copied += from.copied;
+			to.blended += from.blended;
+			to.skipped += from.skipped;
+			to.tilesDrawn += from.tilesDrawn;
+			to.tilesCulled += from.tilesCulled;
+			for (uint8_t i = 0; i < RS_SECTION_COUNT; i++) to.cycles[i] += from.cycles[i];
+		}
+
+		RenderStatsThread::RenderStatsThread(){
+			memset( &stats, 0, sizeof(RenderStats) );
+			std::lock_guard<std::mutex> guard( statsLock );
+			next = statsThreads;
+			statsThreads = this;
+		}
+
+		RenderStatsThread::~RenderStatsThread(){
+			std::lock_guard<std::mutex> guard( statsLock );
+			addStats( statsRetired, stats );
+			RenderStatsThread** link = &statsThreads;
+			while (*link != this) link = &(*link)->next;
+			*link = next;
+		}
+
+		/**
+		 * The statistics being counted by the calling thread
+		 */
+		RenderStats& renderStatsLocal(){
+			static thread_local RenderStatsThread local;
+			return local.stats;
+		}
+	#else
+		RenderStats renderStats;
+	#endif
+
+	/**
+	 * The frequency of renderStatsCycles
+	 */
+	static uint32_t cyclesPerSecond(){
+		#if defined(ARM_DWT_CYCCNT) && defined(F_CPU_ACTUAL)
+			return F_CPU_ACTUAL;
+		#elif (defined(ARM_DWT_CYCCNT) || defined(DWT)) && defined(F_CPU)
+			return F_CPU;
+		#elif MAC_HOST
+			return 1000000000;
+		#else
+			return 1000000;
+		#endif
+	}
+
+	/**
+	 * Start counting
+	 */
+	void renderStatsBegin(){
+		#if defined(ARM_DWT_CYCCNT)
+			ARM_DEMCR |= ARM_DEMCR_TRCENA;
+			ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+		#elif defined(DWT)
+			CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+			DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+		#endif
+		#if MAC_HOST
+			std::lock_guard<std::mutex> guard( statsLock );
+			for (RenderStatsThread* t = statsThreads; t; t = t->next) memset( &t->stats, 0, sizeof(RenderStats) );
+			memset( &statsRetired, 0, sizeof(RenderStats) );
+		#else
+			memset( &renderStats, 0, sizeof(RenderStats) );
+			renderStats.cyclesPerSecond = cyclesPerSecond();
+		#endif
+		memset( &lastFrame, 0, sizeof(RenderStats) );
+		lastFrame.cyclesPerSecond = cyclesPerSecond();
+	}
+
+	/**
+	 * End the current frame and start the next
+	 */
+	const RenderStats& renderStatsEndFrame(){
+		#if MAC_HOST
+			std::lock_guard<std::mutex> guard( statsLock );
+			memset( &lastFrame, 0, sizeof(RenderStats) );
+			lastFrame.cyclesPerSecond = cyclesPerSecond();
+			addStats( lastFrame, statsRetired );
+			memset( &statsRetired, 0, sizeof(RenderStats) );
+			for (RenderStatsThread* t = statsThreads; t; t = t->next){
+				addStats( lastFrame, t->stats );
+				memset( &t->stats, 0, sizeof(RenderStats) );
+			}
+		#else
+			lastFrame = renderStats;
+			memset( &renderStats, 0, sizeof(RenderStats) );
+			renderStats.cyclesPerSecond = lastFrame.cyclesPerSecond;
+		#endif
+		return lastFrame;
+	}
+
+	/**
+	 * The statistics of the last frame that ended
+	 */
+	const RenderStats& renderStatsFrame(){
+		return lastFrame;
+	}
+
+	#endif
+
+} // ns
@@ -0,0 +1,173 @@
+/**
+ * Optional hot-path counters for rendering and pixel conversion
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ *
+ * MIT LICENCE
+ * -----------
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef _MAC_RENDERSTATSH_
+#define _MAC_RENDERSTATSH_ 1
+
+#include "Bitmap.h"
+
+/**
+ * Define MAC_RENDER_STATS as 1 (before including any mac header, or on the compiler
+ * command line) to collect rendering statistics. When it is 0 (default) the MAC_STAT
+ * macros compile to nothing and there is no cost at all.
+ **/
+#ifndef MAC_RENDER_STATS
+	#define MAC_RENDER_STATS 0
+#endif
+
+#if MAC_RENDER_STATS && MAC_HOST
+	#include <chrono>
+#endif
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * Sections of the render code that are timed. Times are inclusive, so a tile layer
+	 * includes the time spent blitting its tiles.
+	 **/
+	typedef enum {
+		RS_BLIT				= 0,	// Drawing tiles, bitmaps and pixels (drawPixels565)
+		RS_FILL				= 1,	// Solid fills
+		RS_TILE_LAYER		= 2,	// Rendering tile layers
+		RS_COMPOSITE		= 3,	// Front to back compositing
+		RS_DISPLAY_LIST		= 4,	// Executing display lists
+		RS_SCROLL			= 5,	// Scroll buffer updates
+		RS_BLUR				= 6,	// Blurs
+		RS_SECTION_COUNT	= 7
+	} RenderSection;
+
+	/**
+	 * Rendering statistics for one frame
+	 **/
+	typedef struct RenderStatsS {
+		uint32_t converted[10];				// Source pixels converted, by PixelFormat
+		uint32_t copied;					// Pixels written without blending (opaque)
+		uint32_t blended;					// Pixels alpha-blended with the destination
+		uint32_t skipped;					// Pixels skipped (transparent, color key or occluded)
+		uint32_t tilesDrawn;				// Tiles (and bitmaps) that were at least partly drawn
+		uint32_t tilesCulled;				// Tiles (and bitmaps) that were entirely clipped
+		uint32_t cycles[RS_SECTION_COUNT];	// Time spent in each section, in cycles (see cyclesPerSecond)
+		uint32_t cyclesPerSecond;			// Cycle counter frequency
+	} RenderStats;
+
+	#if MAC_RENDER_STATS
+
+	#if MAC_HOST
+	/**
+	 * The statistics being counted by the calling thread. Each thread counts into its own
+	 * copy and renderStatsEndFrame adds them up, so threads of a RenderPool can count at the
+	 * same time. Section times are then the sum over all threads.
+	 */
+	RenderStats& renderStatsLocal();
+	#else
+	/**
+	 * The statistics of the frame being rendered
+	 **/
+	extern RenderStats renderStats;
+
+	/**
+	 * The statistics being counted. There is one render thread, so this is renderStats.
+	 */
+	inline RenderStats& renderStatsLocal(){
+		return renderStats;
+	}
+	#endif
+
+	/**
+	 * Read the cycle counter. Uses DWT->CYCCNT on Cortex-M, a steady clock (in ns) on the host,
+	 * and micros() anywhere else.
+	 * @return 	The current count
+	 */
+	inline uint32_t renderStatsCycles(){
+		#if defined(ARM_DWT_CYCCNT)
+			return ARM_DWT_CYCCNT;
+		#elif defined(DWT)
+			return DWT->CYCCNT;
+		#elif MAC_HOST
+			return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()
+			).count();
+		#else
+			return micros();
+		#endif
+	}
+
+	/**
+	 * Start counting. Enables the cycle counter on Cortex-M and resets the current frame.
+	 */
+	void renderStatsBegin();
+
+	/**
+	 * End the current frame and start the next. Call this while no other thread is drawing
+	 * (for example after RenderPool::renderTileLayers565 returns).
+	 * @return 	The statistics of the frame that ended
+	 */
+	const RenderStats& renderStatsEndFrame();
+
+	/**
+	 * The statistics of the last frame that ended
+	 */
+	const RenderStats& renderStatsFrame();
+
+	/**
+	 * Times a section of code from construction until it goes out of scope
+	 **/
+	class RenderStatsTimer {
+		public:
+			RenderStatsTimer( RenderSection section ) : _section( section ), _start( renderStatsCycles() ) {}
+			~RenderStatsTimer(){ renderStatsLocal().cycles[_section] += renderStatsCycles() - _start; }
+		private:
+			RenderSection _section;
+			uint32_t _start;
+	};
+
+	#define MAC_STAT_CONCAT2(a,b) a##b
+	#define MAC_STAT_CONCAT(a,b) MAC_STAT_CONCAT2(a,b)
+	#define MAC_STAT_ADD(field, n) (mac::renderStatsLocal().field += (n))
+	#define MAC_STAT_CONVERTED(pixelFormat, n) (mac::renderStatsLocal().converted[(pixelFormat) % 10] += (n))
+	#define MAC_STAT_TIMER(section) mac::RenderStatsTimer MAC_STAT_CONCAT(_macStatTimer, __LINE__)( section )
+
+	#else
+
+	#define MAC_STAT_ADD(field, n) do{}while(0)
+	#define MAC_STAT_CONVERTED(pixelFormat, n) do{}while(0)
+	#define MAC_STAT_TIMER(section) do{}while(0)
+
+	#endif
+
+} // ns
+
+#endif
@@ -0,0 +1,112 @@
+/**
+ * GUI library for "mac/μac"
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ **/
+
+#include "RenderTarget.h"
+#include "Trace.h"
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * Get the number of bytes of memory needed for a render target
+	 */
+	uint32_t renderTargetSize( PixelFormat pixelFormat, uint16_t width, uint16_t height ){
+		switch (pixelFormat){
+			case mac::PF_565: return width * height * 2;
+			case mac::PF_8565: return width * height * 3;
+			case mac::PF_8888: return width * height * 4;
+			default: return 0;
+		}
+	}
+
+	/**
+	 * Initialise a render target
+	 */
+	boolean renderTargetInit(
+		RenderTarget& target,
+		PixelFormat pixelFormat,
+		uint16_t width,
+		uint16_t height,
+		uint8_t* buffer,
+		RenderTargetCallback render,
+		void* data
+	){
+		uint32_t size = renderTargetSize( pixelFormat, width, height );
+		if (!size) return false;
+		// 8565 has no native type, so it is stored like an asset
+		target.view = {
+			buffer, width, height, size / height, pixelFormat,
+			(pixelFormat == mac::PF_565) ? (uint32_t)RGB565_Transparent : 0,
+			pixelFormat != mac::PF_8565
+		};
+		target.valid = false;
+		target.render = render;
+		target.renderData = data;
+		target.renders = 0;
+		return true;
+	}
+
+	/**
+	 * Initialise a render target with pixel memory from an arena
+	 */
+	boolean renderTargetCreate(
+		RenderTarget& target,
+		Arena& arena,
+		PixelFormat pixelFormat,
+		uint16_t width,
+		uint16_t height,
+		RenderTargetCallback render,
+		void* data,
+		MemoryHint hint
+	){
+		uint32_t size = renderTargetSize( pixelFormat, width, height );
+		if (!size) return false;
+		uint8_t* buffer = (uint8_t*)arenaAlloc( arena, size, hint );
+		if (!buffer) return false;
+		return renderTargetInit( target, pixelFormat, width, height, buffer, render, data );
+	}
+
+	/**
+	 * Redraw the contents of a render target if they are stale
+	 */
+	boolean renderTargetUpdate( RenderTarget& target ){
+		if (target.valid) return false;
+		MAC_TRACE_SCOPE( "renderTarget" );
+		Rect all = { 0, 0, (int16_t)target.view.width, (int16_t)target.view.height };
+		if (target.view.pixelFormat == mac::PF_565){
+			Framebuffer fb = renderTargetFramebuffer( target );
+			fillRect565( fb, all, RGB565_Transparent );
+		}
+		else fillView( target.view, all, 0 );
+		if (target.render) target.render( target, target.renderData );
+		target.valid = true;
+		target.renders++;
+		return true;
+	}
+
+	/**
+	 * Draw a render target into the framebuffer as a single image
+	 */
+	boolean drawRenderTarget565(
+		Framebuffer& fb,
+		RenderTarget& target,
+		int16_t x,
+		int16_t y,
+		const Rect* clip,
+		const BlitEffects* fx
+	){
+		renderTargetUpdate( target );
+		BitmapView dst = framebufferView( fb );
+		return drawView565( dst, target.view, x, y, clip, 0, fx );
+	}
+
+} // ns
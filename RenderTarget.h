@@ -0,0 +1,173 @@
+/**
+ * Offscreen render targets for caching composited widgets
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ *
+ * MIT LICENCE
+ * -----------
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef _MAC_RENDERTARGETH_
+#define _MAC_RENDERTARGETH_ 1
+
+#include "Blit.h"
+#include "Arena.h"
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	typedef struct RenderTargetS RenderTarget;
+
+	/**
+	 * Called to redraw the contents of a render target. The target has already been cleared
+	 * to transparent. Draw into target.view with drawView and fillView, or (for RGB565
+	 * targets) into renderTargetFramebuffer( target ) with any of the RGB565 renderers.
+	 * @param target 	The render target
+	 * @param data 		The user data passed to renderTargetInit
+	 */
+	typedef void (*RenderTargetCallback)( RenderTarget& target, void* data );
+
+	/**
+	 * An offscreen image that caches the result of drawing something (usually a widget made
+	 * of many tiles). It is redrawn only after it has been invalidated, and otherwise drawn
+	 * as a single image. RGB565 targets use the transparent color for empty pixels, so they
+	 * suit contents with hard edges. ARGB8565 and ARGB8888 targets keep the alpha of soft
+	 * edges, so they can be drawn over anything.
+	 **/
+	typedef struct RenderTargetS {
+		BitmapView view;					// The cached pixels
+		boolean valid;						// False if the contents are stale and must be redrawn
+		RenderTargetCallback render;		// Redraws the contents
+		void* renderData;					// User data for the callback
+		uint32_t renders;					// Number of times the contents have been redrawn
+	} RenderTarget;
+
+	/**
+	 * Get the number of bytes of memory needed for a render target
+	 * @param  pixelFormat 	PF_565, PF_8565 or PF_8888
+	 * @param  width 		Width in pixels
+	 * @param  height 		Height in pixels
+	 * @return 				The number of bytes, or 0 if the pixel format is not supported
+	 */
+	uint32_t renderTargetSize( PixelFormat pixelFormat, uint16_t width, uint16_t height );
+
+	/**
+	 * Initialise a render target. It starts out invalid, so it is drawn on first use.
+	 * @param  target 		The render target
+	 * @param  pixelFormat 	PF_565, PF_8565 or PF_8888
+	 * @param  width 		Width in pixels
+	 * @param  height 		Height in pixels
+	 * @param  buffer 		Memory for the pixels (see renderTargetSize). PF_565 and PF_8888 need
+	 *                 		to be aligned to 2 and 4 bytes.
+	 * @param  render 		Callback that redraws the contents
+	 * @param  data 		User data for the callback
+	 * @return 				False if the pixel format is not supported
+	 */
+	boolean renderTargetInit(
+		RenderTarget& target,
+		PixelFormat pixelFormat,
+		uint16_t width,
+		uint16_t height,
+		uint8_t* buffer,
+		RenderTargetCallback render,
+		void* data = 0
+	);
+
+	/**
+	 * Initialise a render target with pixel memory from an arena
+	 * @param  target 		The render target
+	 * @param  arena 		The arena
+	 * @param  pixelFormat 	PF_565, PF_8565 or PF_8888
+	 * @param  width 		Width in pixels
+	 * @param  height 		Height in pixels
+	 * @param  render 		Callback that redraws the contents
+	 * @param  data 		User data for the callback
+	 * @param  hint 		Where the memory should come from
+	 * @return 				False if the pixel format is not supported or the arena is full
+	 */
+	boolean renderTargetCreate(
+		RenderTarget& target,
+		Arena& arena,
+		PixelFormat pixelFormat,
+		uint16_t width,
+		uint16_t height,
+		RenderTargetCallback render,
+		void* data = 0,
+		MemoryHint hint = MR_FAST
+	);
+
+	/**
+	 * Mark the contents of a render target as stale. Call this whenever something that the
+	 * callback draws has changed. It is redrawn the next time it is drawn or updated.
+	 * @param target 	The render target
+	 */
+	inline void renderTargetInvalidate( RenderTarget& target ){
+		target.valid = false;
+	}
+
+	/**
+	 * Redraw the contents of a render target if they are stale
+	 * @param  target 	The render target
+	 * @return 			True if the contents were redrawn
+	 */
+	boolean renderTargetUpdate( RenderTarget& target );
+
+	/**
+	 * Get a RGB565 render target as a framebuffer, so that tile layers, text and the other
+	 * RGB565 renderers can draw into it
+	 * @param  target 	The render target (must be PF_565)
+	 * @return 			The framebuffer
+	 */
+	inline Framebuffer renderTargetFramebuffer( RenderTarget& target ){
+		return { (color565*)target.view.data, target.view.width, target.view.height };
+	}
+
+	/**
+	 * Draw a render target into the framebuffer as a single image, redrawing its contents
+	 * first if they are stale
+	 * @param fb 		The framebuffer to draw into
+	 * @param target 	The render target
+	 * @param x 		Destination x position
+	 * @param y 		Destination y position
+	 * @param clip 		Optional clip rectangle (in addition to the framebuffer bounds)
+	 * @param fx 		Optional color effects (for example to fade the whole widget)
+	 * @return 			False if nothing was drawn (entirely clipped)
+	 */
+	boolean drawRenderTarget565(
+		Framebuffer& fb,
+		RenderTarget& target,
+		int16_t x,
+		int16_t y,
+		const Rect* clip = 0,
+		const BlitEffects* fx = 0
+	);
+
+} // ns
+
+#endif
@@ -0,0 +1,180 @@
+/**
+ * GUI library for "mac/μac"
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ **/
+
+#include "ScrollBuffer.h"
+#include "RenderStats.h"
+#include "Trace.h"
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * A run of the view along one axis that is contiguous in the buffer
+	 */
+	typedef struct ScrollSegmentS {
+		int16_t start;						// Start in buffer coordinates
+		int16_t length;						// Length in pixels
+		int16_t offset;						// Add to a buffer coordinate to get the view coordinate
+	} ScrollSegment;
+
+	/**
+	 * Split a range of the view into (at most 2) runs that are contiguous in a wrapped buffer
+	 * @return The number of segments
+	 */
+	static uint8_t scrollSegments( int16_t v0, int16_t length, uint16_t origin, uint16_t size, ScrollSegment* segments ){
+		uint8_t count = 0;
+		int16_t b0 = v0 + origin;
+		int16_t b1 = b0 + length;
+		if (b0 < size){
+			segments[count++] = { b0, (int16_t)(min( b1, (int16_t)size ) - b0), (int16_t)(-origin) };
+		}
+		if (b1 > size){
+			int16_t s = max( b0, (int16_t)size ) - size;
+			segments[count++] = { s, (int16_t)(b1 - size - s), (int16_t)(size - origin) };
+		}
+		return count;
+	}
+
+	/**
+	 * Render a rectangle of the view into the buffer
+	 * @return The number of pixels rendered
+	 */
+	static uint32_t renderView( ScrollBuffer& sb, const TileLayer* layers, uint8_t layerCount, const Rect& view ){
+		if ((view.w <= 0) || (view.h <= 0)) return 0;
+		ScrollSegment xs[2], ys[2];
+		uint8_t xCount, yCount;
+		if (sb.mode == SB_RING){
+			xCount = scrollSegments( view.x, view.w, sb.originX, sb.fb.width, xs );
+			yCount = scrollSegments( view.y, view.h, sb.originY, sb.fb.height, ys );
+		}
+		else{
+			xs[0] = { view.x, view.w, 0 };
+			ys[0] = { view.y, view.h, 0 };
+			xCount = yCount = 1;
+		}
+		for (uint8_t j = 0; j < yCount; j++){
+			for (uint8_t i = 0; i < xCount; i++){
+				Rect part = { xs[i].start, ys[j].start, xs[i].length, ys[j].length };
+				fillRect565( sb.fb, part, sb.background );
+				for (uint8_t l = 0; l < layerCount; l++){
+					TileLayer layer = layers[l];
+					layer.scrollX += sb.scrollX + xs[i].offset;
+					layer.scrollY += sb.scrollY + ys[j].offset;
+					renderTileLayer565( sb.fb, layer, &part );
+				}
+			}
+		}
+		return view.w * view.h;
+	}
+
+	/**
+	 * Move the pixels in a linear buffer so that new view pixel (x,y) is old pixel (x+dx,y+dy)
+	 */
+	static void scrollLinear( ScrollBuffer& sb, int16_t dx, int16_t dy ){
+		int16_t w = sb.fb.width;
+		int16_t h = sb.fb.height;
+		int16_t count = w - abs( dx );
+		int16_t dstX = (dx < 0) ? -dx : 0;
+		int16_t srcX = (dx > 0) ? dx : 0;
+		if (dy > 0){
+			for (int16_t y = 0; y < h - dy; y++){
+				memmove( sb.fb.data + y * w + dstX, sb.fb.data + (y + dy) * w + srcX, count * sizeof(color565) );
+			}
+		}
+		else{
+			for (int16_t y = h - 1; y >= -dy; y--){
+				memmove( sb.fb.data + y * w + dstX, sb.fb.data + (y + dy) * w + srcX, count * sizeof(color565) );
+			}
+		}
+	}
+
+	/**
+	 * Set up a scroll buffer
+	 */
+	void scrollBufferInit( ScrollBuffer& sb, color565* data, uint16_t width, uint16_t height, ScrollBufferMode mode, color565 background ){
+		sb.fb = { data, width, height };
+		sb.mode = mode;
+		sb.background = background;
+		sb.originX = 0;
+		sb.originY = 0;
+		sb.scrollX = 0;
+		sb.scrollY = 0;
+		sb.valid = false;
+	}
+
+	/**
+	 * Scroll the view and render only what has been exposed
+	 */
+	uint32_t scrollBufferUpdate( ScrollBuffer& sb, const TileLayer* layers, uint8_t layerCount, int32_t scrollX, int32_t scrollY ){
+		MAC_STAT_TIMER( RS_SCROLL );
+		MAC_TRACE_SCOPE( "scroll" );
+		int16_t w = sb.fb.width;
+		int16_t h = sb.fb.height;
+		int32_t dx = scrollX - sb.scrollX;
+		int32_t dy = scrollY - sb.scrollY;
+		sb.scrollX = scrollX;
+		sb.scrollY = scrollY;
+
+		// Nothing reusable, so render everything
+		if (!sb.valid || (abs( dx ) >= w) || (abs( dy ) >= h)){
+			sb.originX = 0;
+			sb.originY = 0;
+			sb.valid = true;
+			return renderView( sb, layers, layerCount, framebufferRect( sb.fb ) );
+		}
+		if (!dx && !dy) return 0;
+
+		if (sb.mode == SB_RING){
+			sb.originX = (sb.originX + dx + w) % w;
+			sb.originY = (sb.originY + dy + h) % h;
+		}
+		else{
+			scrollLinear( sb, dx, dy );
+		}
+
+		// Exposed rows (full width), then exposed columns (for the rows that were kept)
+		int16_t keptY = (dy < 0) ? -dy : 0;
+		int16_t keptH = h - abs( dy );
+		uint32_t pixels = 0;
+		if (dy > 0) pixels += renderView( sb, layers, layerCount, { 0, (int16_t)(h - dy), w, (int16_t)dy } );
+		else if (dy < 0) pixels += renderView( sb, layers, layerCount, { 0, 0, w, (int16_t)-dy } );
+		if (dx > 0) pixels += renderView( sb, layers, layerCount, { (int16_t)(w - dx), keptY, (int16_t)dx, keptH } );
+		else if (dx < 0) pixels += renderView( sb, layers, layerCount, { 0, keptY, (int16_t)-dx, keptH } );
+		return pixels;
+	}
+
+	/**
+	 * Stream an area of the view in display order
+	 */
+	void scrollBufferFlush( const ScrollBuffer& sb, scrollFlushCallback callback, void* data, const Rect* area ){
+		MAC_TRACE_SCOPE( "flush" );
+		Rect view = framebufferRect( sb.fb );
+		if (area && !rectIntersect( view, *area, view )) return;
+		if (sb.mode != SB_RING){
+			callback( sb.fb.data + view.y * sb.fb.width + view.x, sb.fb.width, view.x, view.y, view.w, view.h, data );
+			return;
+		}
+		ScrollSegment xs[2], ys[2];
+		uint8_t xCount = scrollSegments( view.x, view.w, sb.originX, sb.fb.width, xs );
+		uint8_t yCount = scrollSegments( view.y, view.h, sb.originY, sb.fb.height, ys );
+		for (uint8_t j = 0; j < yCount; j++){
+			for (uint8_t i = 0; i < xCount; i++){
+				callback(
+					sb.fb.data + ys[j].start * sb.fb.width + xs[i].start, sb.fb.width,
+					xs[i].start + xs[i].offset, ys[j].start + ys[j].offset, xs[i].length, ys[j].length,
+					data
+				);
+			}
+		}
+	}
+
+} // ns
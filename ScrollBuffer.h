@@ -0,0 +1,127 @@
+/**
+ * Scrolling framebuffer that only renders newly exposed tiles
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ *
+ * MIT LICENCE
+ * -----------
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef _MAC_SCROLLBUFFERH_
+#define _MAC_SCROLLBUFFERH_ 1
+
+#include "Bitmap.h"
+#include "Blit.h"
+#include "TileLayer.h"
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * How a scroll buffer keeps the pixels that are still visible after a scroll
+	 **/
+	typedef enum {
+		SB_RING				= 0,	// The buffer wraps around. Only the origin moves. Work is O(scroll delta).
+		SB_LINEAR			= 1		// Pixels are moved in place with memmove. The buffer is always in display order.
+	} ScrollBufferMode;
+
+	/**
+	 * A framebuffer the size of the viewport that keeps the already rendered pixels when
+	 * the view scrolls, and only renders the newly exposed rows and columns.
+	 * In SB_RING mode the viewport's top-left pixel is at (originX,originY) in the buffer,
+	 * and rows and columns wrap around. Use scrollBufferFlush to stream it in display order.
+	 **/
+	typedef struct ScrollBufferS {
+		Framebuffer fb;						// The pixels (viewport width x height)
+		ScrollBufferMode mode;				// Ring or linear
+		color565 background;				// Color drawn where no tile covers the view
+		uint16_t originX;					// Buffer x of the viewport's left column (SB_RING only)
+		uint16_t originY;					// Buffer y of the viewport's top row (SB_RING only)
+		int32_t scrollX;					// View position that the buffer currently holds
+		int32_t scrollY;					// View position that the buffer currently holds
+		boolean valid;						// False if the whole view must be rendered
+	} ScrollBuffer;
+
+	/**
+	 * Called by scrollBufferFlush for each part of the view that is contiguous in the buffer
+	 * @param pixels 	The first pixel of the part
+	 * @param stride 	Number of pixels from one row to the next
+	 * @param x 		Viewport x of the part
+	 * @param y 		Viewport y of the part
+	 * @param w 		Width of the part
+	 * @param h 		Height of the part
+	 * @param data 		User data passed to scrollBufferFlush
+	 */
+	typedef void (*scrollFlushCallback)( const color565* pixels, uint16_t stride, int16_t x, int16_t y, int16_t w, int16_t h, void* data );
+
+	/**
+	 * Set up a scroll buffer. The first update renders the whole view.
+	 * @param sb 			The scroll buffer
+	 * @param data 			Pixel memory (width x height)
+	 * @param width 		Width of the viewport
+	 * @param height 		Height of the viewport
+	 * @param mode 			Ring or linear
+	 * @param background 	Color drawn where no tile covers the view
+	 */
+	void scrollBufferInit( ScrollBuffer& sb, color565* data, uint16_t width, uint16_t height, ScrollBufferMode mode, color565 background = RGB565_Black );
+
+	/**
+	 * Force the whole view to be rendered on the next update (e.g. after the map changes)
+	 * @param sb 		The scroll buffer
+	 */
+	inline void scrollBufferInvalidate( ScrollBuffer& sb ){
+		sb.valid = false;
+	}
+
+	/**
+	 * Scroll the view and render only what has been exposed. Layers are drawn back to front
+	 * and move together. Each layer's own scrollX/scrollY is an offset from the view position.
+	 * @param  sb 			The scroll buffer
+	 * @param  layers 		The tile layers, back to front
+	 * @param  layerCount 	The number of layers
+	 * @param  scrollX 		The new view position
+	 * @param  scrollY 		The new view position
+	 * @return             	The number of pixels that were rendered
+	 */
+	uint32_t scrollBufferUpdate( ScrollBuffer& sb, const TileLayer* layers, uint8_t layerCount, int32_t scrollX, int32_t scrollY );
+
+	/**
+	 * Stream an area of the view in display order, taking care of the wrapped origin. The
+	 * callback is called once for each part of the area that is contiguous in the buffer
+	 * (up to 4 parts in SB_RING mode, 1 in SB_LINEAR mode), top to bottom.
+	 * @param sb 		The scroll buffer
+	 * @param callback 	Called for each part
+	 * @param data 		User data passed to the callback
+	 * @param area 		Optional area of the viewport to flush. Default is the whole view.
+	 */
+	void scrollBufferFlush( const ScrollBuffer& sb, scrollFlushCallback callback, void* data = 0, const Rect* area = 0 );
+
+} // ns
+
+#endif
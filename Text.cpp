@@ -0,0 +1,320 @@
+/**
+ * GUI library for "mac/μac"
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ **/
+
+#include "Text.h"
+#include "RenderStats.h"
+#include "Trace.h"
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * Number of coverage values converted at a time
+	 */
+	#define MAC_TEXT_CHUNK 64
+
+	/**
+	 * Read the coverage (0-255) of a span of glyph pixels
+	 */
+	static void coverageSpan( const uint8_t* src, PixelFormat pixelFormat, uint32_t transparentColor, uint8_t* out, uint16_t count ){
+		uint8_t* end = out + count;
+		switch (pixelFormat){
+			case mac::PF_GRAYSCALE:
+				memcpy( out, src, count );
+				break;
+			case mac::PF_4444:
+				for (; out < end; src += 2) *out++ = (src[0] & 0xF0) | (src[0] >> 4);
+				break;
+			case mac::PF_6666:
+				for (; out < end; src += 3) *out++ = (src[0] & 0xFC) | (src[0] >> 6);
+				break;
+			case mac::PF_8565:
+				for (; out < end; src += 3) *out++ = src[0];
+				break;
+			case mac::PF_8888:
+				for (; out < end; src += 4) *out++ = src[0];
+				break;
+			case mac::PF_565:
+				for (; out < end; src += 2) *out++ = ((uint32_t)((src[0] << 8) | src[1]) == transparentColor) ? 0 : 255;
+				break;
+			case mac::PF_888:
+				for (; out < end; src += 3) *out++ = ((uint32_t)((src[0] << 16) | (src[1] << 8) | src[2]) == transparentColor) ? 0 : 255;
+				break;
+			default:
+				memset( out, 0, count );
+				break;
+		}
+	}
+
+	/**
+	 * Blend a prepared color over a row of pixels by coverage
+	 */
+	static void blendCoverageSpan( color565* dst, const uint8_t* coverage, uint16_t count, uint32_t prepared, color565 color ){
+		uint32_t copied = 0, blended = 0;
+		for (uint16_t i = 0; i < count; i++){
+			uint8_t a = coverage[i];
+			if (a == 255){
+				dst[i] = color;
+				copied++;
+			}
+			else if (a){
+				dst[i] = alphaBlendPrepared5565( prepared, dst[i], alpha5bit( a ) );
+				blended++;
+			}
+		}
+		MAC_STAT_ADD( copied, copied );
+		MAC_STAT_ADD( blended, blended );
+		MAC_STAT_ADD( skipped, count - copied - blended );
+	}
+
+	/**
+	 * Get the kerning adjustment between two characters
+	 */
+	int8_t fontKerning( const Font& font, uint8_t left, uint8_t right ){
+		if (!font.kerning) return 0;
+		uint16_t pair = (left << 8) | right;
+		int32_t lo = 0, hi = font.kerningCount - 1;
+		while (lo <= hi){
+			int32_t mid = (lo + hi) >> 1;
+			uint16_t p = font.kerning[mid].pair;
+			if (p == pair) return font.kerning[mid].adjust;
+			if (p < pair) lo = mid + 1;
+			else hi = mid - 1;
+		}
+		return 0;
+	}
+
+	/**
+	 * The advance of a character, without kerning
+	 */
+	static inline int16_t glyphAdvance( const Font& font, uint8_t c ){
+		uint8_t glyph = c - font.firstChar;
+		if ((c < font.firstChar) || (glyph >= font.charCount)) return 0;
+		return font.advances ? font.advances[glyph] : font.glyphs->tileWidth;
+	}
+
+	/**
+	 * Measure text. The extent also includes glyph pixels past the last advance.
+	 */
+	static int16_t textMeasure( const Font& font, const char* text, int16_t& extent ){
+		int16_t pen = 0;
+		extent = 0;
+		for (const uint8_t* c = (const uint8_t*)text; *c; c++){
+			if ((*c >= font.firstChar) && ((uint8_t)(*c - font.firstChar) < font.charCount)){
+				extent = max( extent, (int16_t)(pen + font.glyphs->tileWidth) );
+			}
+			pen += glyphAdvance( font, *c ) + fontKerning( font, c[0], c[1] );
+		}
+		extent = max( extent, pen );
+		return pen;
+	}
+
+	/**
+	 * Get the width of a line of text, including kerning
+	 */
+	int16_t textWidth( const Font& font, const char* text ){
+		int16_t extent;
+		return textMeasure( font, text, extent );
+	}
+
+	/**
+	 * Get the width of the pixels drawn for a line of text
+	 */
+	int16_t textExtent( const Font& font, const char* text ){
+		int16_t extent;
+		textMeasure( font, text, extent );
+		return extent;
+	}
+
+	/**
+	 * Draw one glyph in a solid color
+	 */
+	static void drawGlyph565( Framebuffer& fb, const Font& font, uint8_t glyph, int16_t x, int16_t y, uint32_t prepared, color565 color, const Rect& area ){
+		const Tilemap& tm = *font.glyphs;
+		Rect dest = { x, y, (int16_t)tm.tileWidth, (int16_t)tm.tileHeight };
+		if (!rectIntersect( area, dest, dest )){
+			MAC_STAT_ADD( tilesCulled, 1 );
+			return;
+		}
+		MAC_STAT_ADD( tilesDrawn, 1 );
+		MAC_STAT_CONVERTED( tm.pixelFormat, dest.w * dest.h );
+		uint8_t bpp = pixelFormatByteWidth( tm.pixelFormat );
+		uint32_t rowStride = tm.tileWidth * bpp;
+		const uint8_t* src = tm.data + tm.tileStride * glyph + (dest.y - y) * rowStride + (dest.x - x) * bpp;
+		color565* dst = fb.data + dest.y * fb.width + dest.x;
+		uint8_t coverage[MAC_TEXT_CHUNK];
+		for (int16_t row = 0; row < dest.h; row++){
+			for (int16_t i = 0; i < dest.w; i += MAC_TEXT_CHUNK){
+				uint16_t n = min( (int16_t)(dest.w - i), (int16_t)MAC_TEXT_CHUNK );
+				coverageSpan( src + i * bpp, tm.pixelFormat, tm.transparentColor, coverage, n );
+				blendCoverageSpan( dst + i, coverage, n, prepared, color );
+			}
+			src += rowStride;
+			dst += fb.width;
+		}
+	}
+
+	/**
+	 * Draw a line of text in a solid color
+	 */
+	int16_t drawText565( Framebuffer& fb, const Font& font, const char* text, int16_t x, int16_t y, color565 color, const Rect* clip ){
+		MAC_TRACE_SCOPE( "text" );
+		Rect area = framebufferRect( fb );
+		boolean visible = !clip || rectIntersect( area, *clip, area );
+		uint32_t prepared = colorPrepare565( color );
+		for (const uint8_t* c = (const uint8_t*)text; *c; c++){
+			uint8_t glyph = *c - font.firstChar;
+			if (visible && (*c >= font.firstChar) && (glyph < font.charCount)){
+				drawGlyph565( fb, font, glyph, x, y, prepared, color, area );
+			}
+			x += glyphAdvance( font, *c ) + fontKerning( font, c[0], c[1] );
+		}
+		return x;
+	}
+
+	/*
+	 * ### CACHED STRINGS
+	 */
+
+	/**
+	 * Set up a text cache
+	 */
+	void textCacheInit( TextCache& cache, uint8_t* memory, uint32_t size, TextCacheEntry* entries, uint8_t entryCount ){
+		cache.memory = memory;
+		cache.size = size;
+		cache.entries = entries;
+		cache.entryCount = entryCount;
+		textCacheClear( cache );
+	}
+
+	/**
+	 * Remove all strings from a text cache
+	 */
+	void textCacheClear( TextCache& cache ){
+		cache.next = 0;
+		cache.nextEntry = 0;
+		cache.hits = 0;
+		cache.misses = 0;
+		for (uint8_t i = 0; i < cache.entryCount; i++) cache.entries[i].hash = 0;
+	}
+
+	/**
+	 * FNV-1a hash of the font and text
+	 */
+	static uint32_t textHash( const Font& font, const char* text ){
+		uint32_t hash = 2166136261u;
+		uintptr_t f = (uintptr_t)&font;
+		for (uint8_t i = 0; i < sizeof(f); i++){
+			hash = (hash ^ ((f >> (i * 8)) & 0xFF)) * 16777619u;
+		}
+		for (const uint8_t* c = (const uint8_t*)text; *c; c++){
+			hash = (hash ^ *c) * 16777619u;
+		}
+		return hash ? hash : 1;
+	}
+
+	/**
+	 * Render text into a coverage mask. Overlapping glyphs keep the highest coverage.
+	 */
+	static void renderTextMask( const Font& font, const char* text, uint8_t* mask, int16_t w, int16_t h ){
+		const Tilemap& tm = *font.glyphs;
+		uint8_t bpp = pixelFormatByteWidth( tm.pixelFormat );
+		uint32_t rowStride = tm.tileWidth * bpp;
+		uint8_t coverage[MAC_TEXT_CHUNK];
+		memset( mask, 0, w * h );
+		int16_t pen = 0;
+		for (const uint8_t* c = (const uint8_t*)text; *c; c++){
+			uint8_t glyph = *c - font.firstChar;
+			if ((*c >= font.firstChar) && (glyph < font.charCount)){
+				int16_t x0 = max( pen, (int16_t)0 );
+				int16_t x1 = min( (int16_t)(pen + tm.tileWidth), w );
+				for (int16_t row = 0; row < h; row++){
+					const uint8_t* src = tm.data + tm.tileStride * glyph + row * rowStride + (x0 - pen) * bpp;
+					uint8_t* dst = mask + row * w;
+					for (int16_t x = x0; x < x1; x += MAC_TEXT_CHUNK){
+						uint16_t n = min( (int16_t)(x1 - x), (int16_t)MAC_TEXT_CHUNK );
+						coverageSpan( src + (x - x0) * bpp, tm.pixelFormat, tm.transparentColor, coverage, n );
+						for (uint16_t i = 0; i < n; i++) dst[x + i] = max( dst[x + i], coverage[i] );
+					}
+				}
+			}
+			pen += glyphAdvance( font, *c ) + fontKerning( font, c[0], c[1] );
+		}
+	}
+
+	/**
+	 * Draw a line of text from the cache
+	 */
+	int16_t drawTextCached565( Framebuffer& fb, TextCache& cache, const Font& font, const char* text, int16_t x, int16_t y, color565 color, const Rect* clip ){
+		uint32_t hash = textHash( font, text );
+		size_t length = strlen( text );
+		for (uint8_t i = 0; i < cache.entryCount; i++){
+			TextCacheEntry& e = cache.entries[i];
+			// The hash only rules entries out. Check the text too, in case two strings collide.
+			if ((e.hash != hash) || (e.font != &font) || (e.length != length)) continue;
+			if (memcmp( cache.memory + e.offset + e.width * e.height, text, length )) continue;
+			cache.hits++;
+			drawCoverage565( fb, cache.memory + e.offset, e.width, e.height, x, y, color, clip );
+			return x + textWidth( font, text );
+		}
+
+		// Not cached, so render it into the next part of the ring
+		int16_t extent;
+		int16_t width = textMeasure( font, text, extent );
+		int16_t height = font.glyphs->tileHeight;
+		uint32_t maskSize = extent * height;
+		uint32_t size = maskSize + length;
+		if (!maskSize || (length > 0xFFFF) || (size > cache.size) || !cache.entryCount) return drawText565( fb, font, text, x, y, color, clip );
+		if (cache.next + size > cache.size) cache.next = 0;
+		for (uint8_t i = 0; i < cache.entryCount; i++){
+			TextCacheEntry& e = cache.entries[i];
+			if (e.hash && (e.offset < cache.next + size) && (cache.next < e.offset + e.width * e.height + e.length)) e.hash = 0;
+		}
+		TextCacheEntry* entry = 0;
+		for (uint8_t i = 0; i < cache.entryCount; i++){
+			if (!cache.entries[i].hash){
+				entry = &cache.entries[i];
+				break;
+			}
+		}
+		if (!entry){
+			entry = &cache.entries[cache.nextEntry];
+			cache.nextEntry = (cache.nextEntry + 1) % cache.entryCount;
+		}
+		*entry = { hash, cache.next, extent, height, &font, (uint16_t)length };
+		cache.next += size;
+		cache.misses++;
+		renderTextMask( font, text, cache.memory + entry->offset, extent, height );
+		memcpy( cache.memory + entry->offset + maskSize, text, length );
+		drawCoverage565( fb, cache.memory + entry->offset, extent, height, x, y, color, clip );
+		return x + width;
+	}
+
+	/**
+	 * Draw an 8-bit coverage mask in a solid color
+	 */
+	void drawCoverage565( Framebuffer& fb, const uint8_t* mask, int16_t w, int16_t h, int16_t x, int16_t y, color565 color, const Rect* clip ){
+		MAC_TRACE_SCOPE( "coverage" );
+		Rect area = framebufferRect( fb );
+		Rect dest = { x, y, w, h };
+		if ((clip && !rectIntersect( area, *clip, area )) || !rectIntersect( area, dest, area )) return;
+		uint32_t prepared = colorPrepare565( color );
+		const uint8_t* src = mask + (area.y - y) * w + (area.x - x);
+		color565* dst = fb.data + area.y * fb.width + area.x;
+		for (int16_t row = 0; row < area.h; row++){
+			blendCoverageSpan( dst, src, area.w, prepared, color );
+			src += w;
+			dst += fb.width;
+		}
+	}
+
+} // ns
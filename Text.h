@@ -0,0 +1,182 @@
+/**
+ * Text rendering from tilemap fonts, with kerning and cached strings
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ *
+ * MIT LICENCE
+ * -----------
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef _MAC_TEXTH_
+#define _MAC_TEXTH_ 1
+
+#include "Bitmap.h"
+#include "Blit.h"
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * A kerning adjustment for a pair of characters
+	 **/
+	typedef struct KerningPairS {
+		uint16_t pair;						// (left character << 8) | right character
+		int8_t adjust;						// Pixels to add to the advance between them
+	} KerningPair;
+
+	/**
+	 * A font. Glyphs are the tiles of a tilemap (as cut by tilemap_to_h.py with the t-WxH
+	 * option), one per character starting at firstChar, drawn at the top-left of the pen.
+	 * Glyphs are coverage only; the color comes from the text color:
+	 *  - PF_GRAYSCALE glyphs use the gray level as coverage
+	 *  - Formats with alpha (4444, 6666, 8565, 8888) use the alpha channel as coverage
+	 *  - PF_565 and PF_888 glyphs are fully covered except for the transparent color
+	 **/
+	typedef struct FontS {
+		const Tilemap* glyphs;				// The glyph tiles
+		uint8_t firstChar;					// Character of the first tile
+		uint8_t charCount;					// Number of glyphs
+		const uint8_t* advances;			// Advance of each glyph in pixels, or 0 to use the tile width
+		const KerningPair* kerning;			// Kerning pairs sorted by pair, or 0
+		uint16_t kerningCount;				// Number of kerning pairs
+	} Font;
+
+	/**
+	 * Get the kerning adjustment between two characters
+	 * @param  font 	The font
+	 * @param  left 	The left character
+	 * @param  right 	The right character
+	 * @return       	Pixels to add to the advance of the left character
+	 */
+	int8_t fontKerning( const Font& font, uint8_t left, uint8_t right );
+
+	/**
+	 * Get the width of a line of text, including kerning
+	 * @param  font 	The font
+	 * @param  text 	The text
+	 * @return      	Width in pixels
+	 */
+	int16_t textWidth( const Font& font, const char* text );
+
+	/**
+	 * Get the width of the pixels drawn for a line of text. This is textWidth, plus any glyph
+	 * pixels past the last advance.
+	 * @param  font 	The font
+	 * @param  text 	The text
+	 * @return      	Width in pixels
+	 */
+	int16_t textExtent( const Font& font, const char* text );
+
+	/**
+	 * Draw a line of text in a solid color. The color is prepared once (colorPrepare565) and
+	 * each glyph pixel is blended with alphaBlendPrepared5565.
+	 * @param  fb 		The framebuffer to draw into
+	 * @param  font 	The font
+	 * @param  text 	The text
+	 * @param  x 		Framebuffer x position of the pen
+	 * @param  y 		Framebuffer y position of the top of the line
+	 * @param  color 	The text color
+	 * @param  clip 	Optional clip rectangle (in addition to the framebuffer bounds)
+	 * @return       	The x position of the pen after the text
+	 */
+	int16_t drawText565( Framebuffer& fb, const Font& font, const char* text, int16_t x, int16_t y, color565 color, const Rect* clip = 0 );
+
+	/*
+	 * ### CACHED STRINGS
+	 */
+
+	/**
+	 * A pre-rendered string in a text cache
+	 **/
+	typedef struct TextCacheEntryS {
+		uint32_t hash;						// Hash of the font and text (0 if unused)
+		uint32_t offset;					// Offset of the coverage mask in the cache memory
+		int16_t width;						// Width of the mask
+		int16_t height;						// Height of the mask
+		const Font* font;					// The font
+		uint16_t length;					// Length of the text, which is stored after the mask
+	} TextCacheEntry;
+
+	/**
+	 * A small cache of strings pre-rendered as 8-bit coverage masks, for labels that do not
+	 * change between frames. Memory is supplied by the caller and used as a ring, so the oldest
+	 * strings are evicted first.
+	 **/
+	typedef struct TextCacheS {
+		uint8_t* memory;					// Memory for the coverage masks
+		uint32_t size;						// Size of the memory in bytes
+		uint32_t next;						// Offset of the next mask to be rendered
+		TextCacheEntry* entries;			// The entries
+		uint8_t entryCount;					// Number of entries
+		uint8_t nextEntry;					// The entry to reuse next
+		uint32_t hits;						// Number of draws from the cache
+		uint32_t misses;					// Number of draws that had to render the text
+	} TextCache;
+
+	/**
+	 * Set up a text cache
+	 * @param cache 		The text cache
+	 * @param memory 		Memory for the coverage masks (1 byte per pixel) and a copy of each string
+	 * @param size 			Size of the memory in bytes
+	 * @param entries 		Storage for the entries
+	 * @param entryCount 	Number of entries
+	 */
+	void textCacheInit( TextCache& cache, uint8_t* memory, uint32_t size, TextCacheEntry* entries, uint8_t entryCount );
+
+	/**
+	 * Remove all strings from a text cache (e.g. if a font changes)
+	 * @param cache 		The text cache
+	 */
+	void textCacheClear( TextCache& cache );
+
+	/**
+	 * Draw a line of text from the cache, rendering it into the cache first if needed. Text
+	 * that does not fit in the cache is drawn directly. The cache key is the font and the text,
+	 * so the color can change without rendering again. Where glyphs overlap (kerning), the
+	 * cached mask keeps the highest coverage instead of blending both glyphs.
+	 * @see drawText565
+	 */
+	int16_t drawTextCached565( Framebuffer& fb, TextCache& cache, const Font& font, const char* text, int16_t x, int16_t y, color565 color, const Rect* clip = 0 );
+
+	/**
+	 * Draw an 8-bit coverage mask in a solid color
+	 * @param fb 		The framebuffer to draw into
+	 * @param mask 		The coverage (0-255), row by row
+	 * @param w 		Width of the mask
+	 * @param h 		Height of the mask
+	 * @param x 		Framebuffer x position
+	 * @param y 		Framebuffer y position
+	 * @param color 	The color
+	 * @param clip 		Optional clip rectangle (in addition to the framebuffer bounds)
+	 */
+	void drawCoverage565( Framebuffer& fb, const uint8_t* mask, int16_t w, int16_t h, int16_t x, int16_t y, color565 color, const Rect* clip = 0 );
+
+} // ns
+
+#endif
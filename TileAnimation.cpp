@@ -0,0 +1,109 @@
+/**
+ * GUI library for "mac/μac"
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ **/
+
+#include "TileAnimation.h"
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * Set up an animation table
+	 */
+	void tileAnimInit(
+		TileAnimTable& table,
+		TileAnimation* animations,
+		uint16_t count,
+		const TileFrame* frames,
+		uint16_t* tiles,
+		uint32_t* changed,
+		uint32_t tileCount,
+		uint32_t now,
+		const TileAnimation* source
+	){
+		if (source) memcpy( animations, source, count * sizeof(TileAnimation) );
+		table.animations = animations;
+		table.count = count;
+		table.frames = frames;
+		table.tiles = tiles;
+		table.changed = changed;
+		table.tileCount = tileCount;
+		table.start = now;
+		table.changes = 0;
+		for (uint32_t i = 0; i < tileCount; i++) tiles[i] = i;
+		memset( changed, 0, tileAnimChangedWords( tileCount ) * 4 );
+		for (uint16_t i = 0; i < count; i++){
+			TileAnimation& anim = animations[i];
+			anim.frame = 0;
+			anim.period = 0;
+			for (uint16_t f = 0; f < anim.frameCount; f++) anim.period += frames[ anim.firstFrame + f ].duration;
+			if (!anim.frameCount || (anim.baseTile >= tileCount)) continue;
+			tiles[ anim.baseTile ] = frames[ anim.firstFrame ].tile;
+			anim.nextChange = now + frames[ anim.firstFrame ].duration;
+		}
+	}
+
+	/**
+	 * Advance the animations to a clock time
+	 */
+	uint16_t tileAnimTick( TileAnimTable& table, uint32_t now ){
+		if (table.changes) memset( table.changed, 0, tileAnimChangedWords( table.tileCount ) * 4 );
+		table.changes = 0;
+		for (uint16_t i = 0; i < table.count; i++){
+			TileAnimation& anim = table.animations[i];
+			if ((anim.frameCount < 2) || !anim.period || (anim.baseTile >= table.tileCount)) continue;
+			if ((int32_t)(now - anim.nextChange) < 0) continue;
+
+			// Find the frame from the clock, so a late tick does not drift
+			const TileFrame* frames = table.frames + anim.firstFrame;
+			uint32_t t = (now - table.start) % anim.period;
+			uint16_t f = 0;
+			uint32_t end = frames[0].duration;
+			while (t >= end) end += frames[ ++f ].duration;
+			anim.frame = f;
+			anim.nextChange = now - t + end;
+
+			if (table.tiles[ anim.baseTile ] == frames[f].tile) continue;
+			table.tiles[ anim.baseTile ] = frames[f].tile;
+			table.changed[ anim.baseTile >> 5 ] |= 1u << (anim.baseTile & 31);
+			table.changes++;
+		}
+		return table.changes;
+	}
+
+	/**
+	 * Call a callback for each cell of a layer that changed on the last tick
+	 */
+	uint32_t tileAnimChangedCells( const TileAnimTable& table, const TileLayer& layer, const Rect& area, TileCellCallback callback, void* data ){
+		if (!table.changes || !layer.tilemap || !layer.map) return 0;
+		int32_t tw = layer.tilemap->tileWidth;
+		int32_t th = layer.tilemap->tileHeight;
+		if (!tw || !th || (area.w <= 0) || (area.h <= 0)) return 0;
+
+		// The cells that touch the area, clipped to the map
+		int32_t col0 = max( floorDiv( layer.scrollX + area.x, tw ), (int32_t)0 );
+		int32_t row0 = max( floorDiv( layer.scrollY + area.y, th ), (int32_t)0 );
+		int32_t col1 = min( floorDiv( layer.scrollX + area.x + area.w - 1, tw ), (int32_t)layer.mapWidth - 1 );
+		int32_t row1 = min( floorDiv( layer.scrollY + area.y + area.h - 1, th ), (int32_t)layer.mapHeight - 1 );
+
+		uint32_t cells = 0;
+		for (int32_t row = row0; row <= row1; row++){
+			const uint16_t* map = layer.map + row * layer.mapWidth;
+			for (int32_t col = col0; col <= col1; col++){
+				if (!tileAnimChanged( table, map[col] )) continue;
+				callback( col, row, data );
+				cells++;
+			}
+		}
+		return cells;
+	}
+
+} // ns
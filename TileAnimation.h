@@ -0,0 +1,158 @@
+/**
+ * Animated tiles, resolved at draw time from a clock
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ *
+ * MIT LICENCE
+ * -----------
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef _MAC_TILEANIMATIONH_
+#define _MAC_TILEANIMATIONH_ 1
+
+#include "Bitmap.h"
+#include "TileLayer.h"
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * One frame of a tile animation
+	 **/
+	typedef struct TileFrameS {
+		uint16_t tile;						// Tile index to draw
+		uint16_t duration;					// How long the frame shows, in milliseconds
+	} TileFrame;
+
+	/**
+	 * A tile animation. Cells of the map that hold the base tile are drawn with the current
+	 * frame instead. The last three members are set by tileAnimInit and tileAnimTick.
+	 **/
+	typedef struct TileAnimationS {
+		uint16_t baseTile;					// Tile index that is placed in the map
+		uint16_t firstFrame;				// Index of the first frame in the frame table
+		uint16_t frameCount;				// Number of frames
+		uint16_t frame;						// The current frame
+		uint32_t period;					// Total duration of all frames
+		uint32_t nextChange;				// Clock time when the current frame ends
+	} TileAnimation;
+
+	/**
+	 * A table of tile animations for one tilemap. The tiles array is the tile to draw for each
+	 * tile index. Set it and tileCount as the tiles and tileCount of a TileLayer so that the
+	 * animations are resolved when the layer is drawn, without changing the map.
+	 **/
+	typedef struct TileAnimTableS {
+		TileAnimation* animations;			// The animations
+		uint16_t count;						// Number of animations
+		const TileFrame* frames;			// The frame table
+		uint16_t* tiles;					// Tile to draw for each tile index (tileCount)
+		uint32_t* changed;					// One bit per tile index that changed on the last tick
+		uint32_t tileCount;					// Number of tiles in the tilemap
+		uint32_t start;						// Clock time when every animation was on its first frame
+		uint16_t changes;					// Number of animations that changed on the last tick
+	} TileAnimTable;
+
+	/**
+	 * Called for each cell that needs to be redrawn
+	 * @param col 		The column of the cell
+	 * @param row 		The row of the cell
+	 * @param data 		User data
+	 */
+	typedef void (*TileCellCallback)( int32_t col, int32_t row, void* data );
+
+	/**
+	 * Number of 32-bit words needed for the changed bits of a table
+	 * @param  tileCount 	Number of tiles in the tilemap
+	 * @return       		Number of words
+	 */
+	inline uint32_t tileAnimChangedWords( uint32_t tileCount ){
+		return (tileCount + 31) >> 5;
+	}
+
+	/**
+	 * Set up an animation table. All animations start on their first frame.
+	 * @param  table 		The table
+	 * @param  animations 	The animations
+	 * @param  count 		Number of animations
+	 * @param  frames 		The frame table
+	 * @param  tiles 		Memory for the tile of each tile index (tileCount entries)
+	 * @param  changed 		Memory for the changed bits (tileAnimChangedWords entries)
+	 * @param  tileCount 	Number of tiles in the tilemap
+	 * @param  now 			The clock time (e.g. millis())
+	 * @param  source 		If set, the animations are first copied from here (e.g. the const
+	 *                 		table output by the converter), so they can live in flash
+	 */
+	void tileAnimInit(
+		TileAnimTable& table,
+		TileAnimation* animations,
+		uint16_t count,
+		const TileFrame* frames,
+		uint16_t* tiles,
+		uint32_t* changed,
+		uint32_t tileCount,
+		uint32_t now,
+		const TileAnimation* source = 0
+	);
+
+	/**
+	 * Advance the animations to a clock time. Only animations whose frame has ended are
+	 * looked at, and only those whose tile changed are marked as changed.
+	 * @param  table 	The table
+	 * @param  now 		The clock time (e.g. millis())
+	 * @return       	Number of animations whose tile changed
+	 */
+	uint16_t tileAnimTick( TileAnimTable& table, uint32_t now );
+
+	/**
+	 * Check if the tile drawn for a tile index changed on the last tick
+	 * @param  table 	The table
+	 * @param  index 	The tile index (as in the map)
+	 * @return       	True if it changed
+	 */
+	inline boolean tileAnimChanged( const TileAnimTable& table, uint16_t index ){
+		if (index >= table.tileCount) return false;
+		return (table.changed[ index >> 5 ] >> (index & 31)) & 1;
+	}
+
+	/**
+	 * Call a callback for each cell of a layer that changed on the last tick and touches
+	 * an area of the framebuffer. Use tileLayerCellRect to get the area to redraw.
+	 * @param  table 		The table
+	 * @param  layer 		The tile layer
+	 * @param  area 		The visible area of the framebuffer
+	 * @param  callback 	Called for each changed cell
+	 * @param  data 		User data for the callback
+	 * @return          	Number of changed cells
+	 */
+	uint32_t tileAnimChangedCells( const TileAnimTable& table, const TileLayer& layer, const Rect& area, TileCellCallback callback, void* data = 0 );
+
+} // ns
+
+#endif
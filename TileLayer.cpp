@@ -0,0 +1,50 @@
+/**
+ * GUI library for "mac/μac"
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ **/
+
+#include "TileLayer.h"
+#include "RenderStats.h"
+#include "Trace.h"
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * Render a tile layer into a framebuffer
+	 */
+	void renderTileLayer565( Framebuffer& fb, const TileLayer& layer, const Rect* clip ){
+		MAC_STAT_TIMER( RS_TILE_LAYER );
+		MAC_TRACE_SCOPE( "tileLayer" );
+		Rect area = framebufferRect( fb );
+		if (clip && !rectIntersect( area, *clip, area )) return;
+		if (!layer.tilemap || !layer.map) return;
+
+		int32_t tw = layer.tilemap->tileWidth;
+		int32_t th = layer.tilemap->tileHeight;
+		if (!tw || !th) return;
+
+		// The cells that touch the clip area
+		int32_t col0 = floorDiv( layer.scrollX + area.x, tw );
+		int32_t row0 = floorDiv( layer.scrollY + area.y, th );
+		int32_t col1 = floorDiv( layer.scrollX + area.x + area.w - 1, tw );
+		int32_t row1 = floorDiv( layer.scrollY + area.y + area.h - 1, th );
+
+		for (int32_t row = row0; row <= row1; row++){
+			int16_t y = (int16_t)(row * th - layer.scrollY);
+			for (int32_t col = col0; col <= col1; col++){
+				uint16_t index = tileLayerTile( layer, col, row );
+				if (index == TILE_NONE) continue;
+				drawTile565( fb, *layer.tilemap, index, (int16_t)(col * tw - layer.scrollX), y, &area );
+			}
+		}
+	}
+
+} // ns
@@ -0,0 +1,126 @@
+/**
+ * Scrolling tile layers built from a Tilemap and a map of tile indexes
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ *
+ * MIT LICENCE
+ * -----------
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef _MAC_TILELAYERH_
+#define _MAC_TILELAYERH_ 1
+
+#include "Bitmap.h"
+#include "Blit.h"
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * Map value for an empty cell. Nothing is drawn for empty cells.
+	 **/
+	const uint16_t TILE_NONE = 0xFFFF;
+
+	/**
+	 * A layer of tiles. The map holds one tile index per cell, row by row. The layer is
+	 * positioned so that layer pixel (scrollX,scrollY) is drawn at framebuffer pixel (0,0).
+	 * Cells outside the map are empty.
+	 **/
+	typedef struct TileLayerS {
+		const Tilemap* tilemap;				// The tiles to draw from
+		const uint16_t* map;				// Tile index of each cell (mapWidth x mapHeight)
+		uint16_t mapWidth;					// Width of the map in cells
+		uint16_t mapHeight;					// Height of the map in cells
+		int32_t scrollX;					// Layer x position drawn at the framebuffer origin
+		int32_t scrollY;					// Layer y position drawn at the framebuffer origin
+		const uint16_t* tiles;				// Optional tile to draw for each tile index (e.g. from a TileAnimTable)
+		uint32_t tileCount;					// Number of entries in tiles. Larger tile indexes are drawn as is.
+	} TileLayer;
+
+	/**
+	 * Get the tile index of a cell in the layer
+	 * @param  layer 	The tile layer
+	 * @param  col 		The column of the cell
+	 * @param  row 		The row of the cell
+	 * @return       	The tile index, or TILE_NONE if the cell is outside the map
+	 */
+	inline uint16_t tileLayerCell( const TileLayer& layer, int32_t col, int32_t row ){
+		if ((col < 0) || (row < 0) || (col >= layer.mapWidth) || (row >= layer.mapHeight)) return TILE_NONE;
+		return layer.map[ row * layer.mapWidth + col ];
+	}
+
+	/**
+	 * Get the tile to draw for a cell in the layer. This is the same as tileLayerCell unless
+	 * the layer has a tiles table (for example for animated tiles) that holds the index.
+	 * @param  layer 	The tile layer
+	 * @param  col 		The column of the cell
+	 * @param  row 		The row of the cell
+	 * @return       	The tile index, or TILE_NONE if the cell is outside the map
+	 */
+	inline uint16_t tileLayerTile( const TileLayer& layer, int32_t col, int32_t row ){
+		uint16_t index = tileLayerCell( layer, col, row );
+		if (!layer.tiles || (index >= layer.tileCount)) return index;
+		return layer.tiles[ index ];
+	}
+
+	/**
+	 * Get the framebuffer rectangle that a cell of the layer is drawn to
+	 * @param  layer 	The tile layer (must have a tilemap)
+	 * @param  col 		The column of the cell
+	 * @param  row 		The row of the cell
+	 * @return       	The rectangle
+	 */
+	inline Rect tileLayerCellRect( const TileLayer& layer, int32_t col, int32_t row ){
+		int32_t tw = layer.tilemap->tileWidth;
+		int32_t th = layer.tilemap->tileHeight;
+		return { (int16_t)(col * tw - layer.scrollX), (int16_t)(row * th - layer.scrollY), (int16_t)tw, (int16_t)th };
+	}
+
+	/**
+	 * Floor division, for converting (possibly negative) pixel positions to cells
+	 * @param  a 		The value to divide
+	 * @param  b 		The divisor (must be positive)
+	 * @return   		a / b rounded towards negative infinity
+	 */
+	inline int32_t floorDiv( int32_t a, int32_t b ){
+		return (a >= 0) ? (a / b) : -((b - 1 - a) / b);
+	}
+
+	/**
+	 * Render a tile layer into a framebuffer. Only the tiles that touch the clip rectangle
+	 * are drawn, and no pixel outside of it is written.
+	 * @param fb 		The framebuffer to draw into
+	 * @param layer 	The tile layer
+	 * @param clip 		Optional clip rectangle (in addition to the framebuffer bounds)
+	 */
+	void renderTileLayer565( Framebuffer& fb, const TileLayer& layer, const Rect* clip = 0 );
+
+} // ns
+
+#endif
@@ -0,0 +1,319 @@
+/**
+ * GUI library for "mac/μac"
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ **/
+
+#include "TilePrefetch.h"
+#include "RenderStats.h"
+#include "Trace.h"
+
+#if MAC_HOST
+	#include <chrono>
+#endif
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * Set up a tile cache in memory supplied by the caller
+	 */
+	void tileCacheInit(
+		TileCache& cache,
+		const Tilemap& tilemap,
+		uint8_t* memory,
+		TileCacheSlot* slots,
+		uint16_t slotCount,
+		uint16_t* lookup,
+		TileRequestCallback request,
+		void* data
+	){
+		cache.tilemap = &tilemap;
+		cache.memory = memory;
+		cache.slots = slots;
+		cache.slotCount = slotCount;
+		cache.lookup = lookup;
+		cache.request = request;
+		cache.requestData = data;
+		cache.frame = 1;
+		memset( &cache.stats, 0, sizeof(cache.stats) );
+		for (uint16_t i = 0; i < slotCount; i++) slots[i] = { TILE_NONE, TC_EMPTY, false, 0 };
+		for (uint32_t i = 0; i < tilemap.tileCount; i++) lookup[i] = TILE_NONE;
+	}
+
+	/**
+	 * Set up a tile cache with memory from an arena
+	 */
+	boolean tileCacheCreate(
+		TileCache& cache,
+		Arena& arena,
+		const Tilemap& tilemap,
+		uint16_t slotCount,
+		TileRequestCallback request,
+		void* data,
+		MemoryHint hint
+	){
+		ArenaMark mark = arenaMark( arena );
+		uint8_t* memory = (uint8_t*)arenaAlloc( arena, slotCount * tilemap.tileStride, hint );
+		TileCacheSlot* slots = (TileCacheSlot*)arenaAlloc( arena, slotCount * sizeof(TileCacheSlot) );
+		uint16_t* lookup = (uint16_t*)arenaAlloc( arena, tilemap.tileCount * 2 );
+		if (!memory || !slots || !lookup){
+			arenaRelease( arena, mark );
+			return false;
+		}
+		tileCacheInit( cache, tilemap, memory, slots, slotCount, lookup, request, data );
+		return true;
+	}
+
+	/**
+	 * Get the state of a slot, seeing the tile data if it is ready
+	 */
+	static inline uint8_t slotState( const TileCacheSlot& slot ){
+		return __atomic_load_n( &slot.state, __ATOMIC_ACQUIRE );
+	}
+
+	/**
+	 * Find a slot to load into: an empty one, or the least recently drawn tile that is not
+	 * loading and was not drawn this frame
+	 */
+	static uint16_t evictSlot( TileCache& cache ){
+		uint16_t best = TILE_NONE;
+		for (uint16_t i = 0; i < cache.slotCount; i++){
+			TileCacheSlot& slot = cache.slots[i];
+			if (slot.index == TILE_NONE) return i;
+			if ((slot.lastUsed == cache.frame) || (slotState( slot ) == TC_LOADING)) continue;
+			if ((best == TILE_NONE) || (slot.lastUsed < cache.slots[ best ].lastUsed)) best = i;
+		}
+		if (best != TILE_NONE){
+			TileCacheSlot& slot = cache.slots[ best ];
+			if (slot.prefetched) cache.stats.wastedLoads++;
+			cache.lookup[ slot.index ] = TILE_NONE;
+			slot.index = TILE_NONE;
+		}
+		return best;
+	}
+
+	/**
+	 * Request a tile if it is not cached or loading
+	 */
+	boolean tileCacheRequest( TileCache& cache, uint16_t index, boolean prefetch ){
+		if (index >= cache.tilemap->tileCount) return false;
+		uint16_t s = cache.lookup[ index ];
+		if (s != TILE_NONE){
+			// A failed load is tried again in the same slot
+			if (slotState( cache.slots[s] ) != TC_EMPTY) return true;
+		}
+		else {
+			s = evictSlot( cache );
+			if (s == TILE_NONE) return false;
+			cache.lookup[ index ] = s;
+		}
+		TileCacheSlot& slot = cache.slots[s];
+		slot.index = index;
+		slot.prefetched = prefetch;
+		slot.lastUsed = cache.frame;
+		__atomic_store_n( &slot.state, (uint8_t)TC_LOADING, __ATOMIC_RELAXED );
+		if (prefetch) cache.stats.prefetches++;
+		else cache.stats.loads++;
+		cache.request( cache, s, index, cache.requestData );
+		return true;
+	}
+
+	/**
+	 * Get a tile's data to draw
+	 */
+	const uint8_t* tileCacheGet( TileCache& cache, uint16_t index ){
+		if (index >= cache.tilemap->tileCount) return 0;
+		uint16_t s = cache.lookup[ index ];
+		if ((s != TILE_NONE) && (slotState( cache.slots[s] ) == TC_READY)){
+			TileCacheSlot& slot = cache.slots[s];
+			if (slot.prefetched) cache.stats.prefetchHits++;
+			slot.prefetched = false;
+			slot.lastUsed = cache.frame;
+			cache.stats.hits++;
+			return tileCacheSlotData( cache, s );
+		}
+
+		// Late. A blocking request callback has the tile ready straight away.
+		cache.stats.lateTiles++;
+		if (!tileCacheRequest( cache, index )) return 0;
+		s = cache.lookup[ index ];
+		TileCacheSlot& slot = cache.slots[s];
+		slot.prefetched = false;
+		slot.lastUsed = cache.frame;
+		return (slotState( slot ) == TC_READY) ? tileCacheSlotData( cache, s ) : 0;
+	}
+
+	/**
+	 * Request the tiles that are about to scroll into view
+	 */
+	uint16_t tilePrefetch(
+		TileCache& cache,
+		const TileLayer& layer,
+		uint16_t viewWidth,
+		uint16_t viewHeight,
+		int16_t velocityX,
+		int16_t velocityY,
+		uint8_t lookahead
+	){
+		MAC_TRACE_SCOPE( "prefetch" );
+		if (!layer.map || (!velocityX && !velocityY) || !lookahead) return 0;
+		int32_t tw = cache.tilemap->tileWidth;
+		int32_t th = cache.tilemap->tileHeight;
+		if (!tw || !th) return 0;
+
+		// The cells of the view moved ahead, clipped to the map
+		int32_t x = layer.scrollX + velocityX * lookahead;
+		int32_t y = layer.scrollY + velocityY * lookahead;
+		int32_t col0 = max( floorDiv( x, tw ), (int32_t)0 );
+		int32_t row0 = max( floorDiv( y, th ), (int32_t)0 );
+		int32_t col1 = min( floorDiv( x + viewWidth - 1, tw ), (int32_t)layer.mapWidth - 1 );
+		int32_t row1 = min( floorDiv( y + viewHeight - 1, th ), (int32_t)layer.mapHeight - 1 );
+		if ((col1 < col0) || (row1 < row0)) return 0;
+
+		// Step from the side nearest the current view towards the leading edge
+		int32_t colStep = (velocityX < 0) ? -1 : 1;
+		int32_t rowStep = (velocityY < 0) ? -1 : 1;
+		if (colStep < 0){
+			int32_t t = col0; col0 = col1; col1 = t;
+		}
+		if (rowStep < 0){
+			int32_t t = row0; row0 = row1; row1 = t;
+		}
+		uint16_t requested = 0;
+		for (int32_t row = row0; row != row1 + rowStep; row += rowStep){
+			for (int32_t col = col0; col != col1 + colStep; col += colStep){
+				uint16_t index = tileLayerTile( layer, col, row );
+				if ((index >= cache.tilemap->tileCount) || (cache.lookup[ index ] != TILE_NONE)) continue;
+				if (!tileCacheRequest( cache, index, true )) return requested;
+				requested++;
+			}
+		}
+		return requested;
+	}
+
+	/**
+	 * Render a tile layer with tiles from a cache
+	 */
+	void renderTileLayerCached565( Framebuffer& fb, const TileLayer& layer, TileCache& cache, const Rect* clip ){
+		MAC_STAT_TIMER( RS_TILE_LAYER );
+		MAC_TRACE_SCOPE( "tileLayerCached" );
+		Rect area = framebufferRect( fb );
+		if (clip && !rectIntersect( area, *clip, area )) return;
+		if (!layer.map) return;
+
+		Tilemap tile = *cache.tilemap;
+		tile.dataSize = tile.tileStride;
+		tile.tileCount = 1;
+		int32_t tw = tile.tileWidth;
+		int32_t th = tile.tileHeight;
+		if (!tw || !th) return;
+
+		int32_t col0 = floorDiv( layer.scrollX + area.x, tw );
+		int32_t row0 = floorDiv( layer.scrollY + area.y, th );
+		int32_t col1 = floorDiv( layer.scrollX + area.x + area.w - 1, tw );
+		int32_t row1 = floorDiv( layer.scrollY + area.y + area.h - 1, th );
+
+		for (int32_t row = row0; row <= row1; row++){
+			int16_t y = (int16_t)(row * th - layer.scrollY);
+			for (int32_t col = col0; col <= col1; col++){
+				uint16_t index = tileLayerTile( layer, col, row );
+				if (index == TILE_NONE) continue;
+				tile.data = tileCacheGet( cache, index );
+				if (!tile.data) continue;
+				drawTile565( fb, tile, 0, (int16_t)(col * tw - layer.scrollX), y, &area );
+			}
+		}
+	}
+
+	/*
+	 * ### BACKGROUND LOADING (host only)
+	 */
+	#if MAC_HOST
+
+	/**
+	 * Read callback for tiles stored one after another in a file
+	 */
+	boolean tileReadFile( uint16_t index, uint8_t* dst, void* data ){
+		TileFile& tf = *(TileFile*)data;
+		if (fseek( tf.file, tf.offset + (uint32_t)index * tf.tileStride, SEEK_SET )) return false;
+		return fread( dst, 1, tf.tileStride, tf.file ) == tf.tileStride;
+	}
+
+	/**
+	 * Start the thread
+	 */
+	TileLoaderThread::TileLoaderThread( TileReadCallback read, void* data, uint32_t latencyUs ) :
+		_read( read ),
+		_readData( data ),
+		_latencyUs( latencyUs ),
+		_busy( false ),
+		_stop( false ){
+		_thread = std::thread( &TileLoaderThread::workerLoop, this );
+	}
+
+	/**
+	 * Stop the thread. Requests that have not started are dropped.
+	 */
+	TileLoaderThread::~TileLoaderThread(){
+		{
+			std::lock_guard<std::mutex> guard( _lock );
+			_stop = true;
+		}
+		_wake.notify_all();
+		_thread.join();
+	}
+
+	/**
+	 * Request callback for a TileCache
+	 */
+	void TileLoaderThread::request( TileCache& cache, uint16_t slot, uint16_t index, void* data ){
+		TileLoaderThread& loader = *(TileLoaderThread*)data;
+		{
+			std::lock_guard<std::mutex> guard( loader._lock );
+			loader._jobs.push_back( { &cache, slot, index } );
+		}
+		loader._wake.notify_one();
+	}
+
+	/**
+	 * Wait until every request has been loaded
+	 */
+	void TileLoaderThread::wait(){
+		std::unique_lock<std::mutex> guard( _lock );
+		_idle.wait( guard, [this]{ return _jobs.empty() && !_busy; } );
+	}
+
+	/**
+	 * Load tiles one at a time, in the order they were requested
+	 */
+	void TileLoaderThread::workerLoop(){
+		std::unique_lock<std::mutex> guard( _lock );
+		while (true){
+			_wake.wait( guard, [this]{ return _stop || !_jobs.empty(); } );
+			if (_stop) return;
+			Job job = _jobs.front();
+			_jobs.pop_front();
+			_busy = true;
+			guard.unlock();
+
+			uint32_t latency = _latencyUs;
+			if (latency) std::this_thread::sleep_for( std::chrono::microseconds( latency ) );
+			boolean ok = _read( job.index, tileCacheSlotData( *job.cache, job.slot ), _readData );
+			tileCacheLoaded( *job.cache, job.slot, ok );
+
+			guard.lock();
+			_busy = false;
+			if (_jobs.empty()) _idle.notify_all();
+		}
+	}
+
+	#endif
+
+} // ns
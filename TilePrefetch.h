@@ -0,0 +1,315 @@
+/**
+ * Tile cache with scroll-predictive prefetch for file-backed tilemaps
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ *
+ * MIT LICENCE
+ * -----------
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef _MAC_TILEPREFETCHH_
+#define _MAC_TILEPREFETCHH_ 1
+
+#include "Bitmap.h"
+#include "Blit.h"
+#include "TileLayer.h"
+#include "Arena.h"
+
+#if MAC_HOST
+	#include <atomic>
+	#include <condition_variable>
+	#include <deque>
+	#include <mutex>
+	#include <stdio.h>
+	#include <thread>
+#endif
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	/**
+	 * State of a slot in a tile cache
+	 **/
+	typedef enum {
+		TC_EMPTY			= 0,	// Nothing loaded
+		TC_LOADING			= 1,	// A load has been requested
+		TC_READY			= 2		// The tile data is ready
+	} TileSlotState;
+
+	/**
+	 * One slot of a tile cache
+	 **/
+	typedef struct TileCacheSlotS {
+		uint16_t index;						// The tile in the slot (TILE_NONE if none)
+		uint8_t state;						// TileSlotState. Set by tileCacheLoaded from any thread.
+		boolean prefetched;					// Loaded ahead of time and not drawn yet
+		uint32_t lastUsed;					// Frame the tile was last drawn
+	} TileCacheSlot;
+
+	/**
+	 * Counters of a tile cache
+	 **/
+	typedef struct TileCacheStatsS {
+		uint32_t hits;						// Tiles drawn from the cache
+		uint32_t prefetchHits;				// Tiles drawn for the first time after being prefetched
+		uint32_t lateTiles;					// Tiles that were not ready when they were drawn
+		uint32_t wastedLoads;				// Prefetched tiles that were evicted without being drawn
+		uint32_t loads;						// Loads requested on demand
+		uint32_t prefetches;				// Loads requested ahead of time
+	} TileCacheStats;
+
+	typedef struct TileCacheS TileCache;
+
+	/**
+	 * Starts loading a tile. Read tileStride bytes into tileCacheSlotData( cache, slot ), then
+	 * call tileCacheLoaded. This can happen before returning (a blocking read) or later from
+	 * another thread, a DMA interrupt or the main loop.
+	 * @param cache 	The cache
+	 * @param slot 		The slot to load into
+	 * @param index 	The tile to load
+	 * @param data 		User data
+	 */
+	typedef void (*TileRequestCallback)( TileCache& cache, uint16_t slot, uint16_t index, void* data );
+
+	/**
+	 * A cache of tiles for a tilemap that is too large to keep in memory. Tiles are looked
+	 * up in O(1) and the least recently drawn tile is evicted when a slot is needed.
+	 **/
+	typedef struct TileCacheS {
+		const Tilemap* tilemap;				// Tile size, count and format (data is not used)
+		uint8_t* memory;					// Tile data (slotCount x tileStride bytes)
+		TileCacheSlot* slots;				// The slots
+		uint16_t slotCount;					// Number of slots
+		uint16_t* lookup;					// Slot of each tile index, or TILE_NONE (tileCount entries)
+		TileRequestCallback request;		// Starts loading a tile
+		void* requestData;					// User data for request
+		uint32_t frame;						// The current frame
+		TileCacheStats stats;				// The counters
+	} TileCache;
+
+	/**
+	 * Set up a tile cache in memory supplied by the caller
+	 * @param cache 		The cache
+	 * @param tilemap 		The tilemap (only the size, count and format are used)
+	 * @param memory 		Memory for the tile data (slotCount x tileStride bytes, 4-byte aligned)
+	 * @param slots 		Memory for the slots (slotCount entries)
+	 * @param slotCount 	Number of tiles to hold
+	 * @param lookup 		Memory for the lookup table (tileCount entries)
+	 * @param request 		Starts loading a tile
+	 * @param data 			User data for request
+	 */
+	void tileCacheInit(
+		TileCache& cache,
+		const Tilemap& tilemap,
+		uint8_t* memory,
+		TileCacheSlot* slots,
+		uint16_t slotCount,
+		uint16_t* lookup,
+		TileRequestCallback request,
+		void* data = 0
+	);
+
+	/**
+	 * Set up a tile cache with memory from an arena
+	 * @return 	False if the arena did not have enough memory
+	 * @see tileCacheInit
+	 */
+	boolean tileCacheCreate(
+		TileCache& cache,
+		Arena& arena,
+		const Tilemap& tilemap,
+		uint16_t slotCount,
+		TileRequestCallback request,
+		void* data = 0,
+		MemoryHint hint = MR_FAST
+	);
+
+	/**
+	 * Get the memory of a slot, for the request callback to load into
+	 * @param  cache 	The cache
+	 * @param  slot 	The slot
+	 * @return       	The slot's tile data
+	 */
+	inline uint8_t* tileCacheSlotData( TileCache& cache, uint16_t slot ){
+		return cache.memory + slot * cache.tilemap->tileStride;
+	}
+
+	/**
+	 * Finish loading a slot. Safe to call from another thread or an interrupt.
+	 * @param cache 	The cache
+	 * @param slot 		The slot
+	 * @param ok 		False if the read failed (the tile is requested again when needed)
+	 */
+	inline void tileCacheLoaded( TileCache& cache, uint16_t slot, boolean ok = true ){
+		__atomic_store_n( &cache.slots[ slot ].state, (uint8_t)(ok ? TC_READY : TC_EMPTY), __ATOMIC_RELEASE );
+	}
+
+	/**
+	 * Start a new frame. Tiles drawn in the current frame are never evicted.
+	 * @param cache 	The cache
+	 */
+	inline void tileCacheBeginFrame( TileCache& cache ){
+		cache.frame++;
+	}
+
+	/**
+	 * Request a tile if it is not cached or loading
+	 * @param  cache 		The cache
+	 * @param  index 		The tile index
+	 * @param  prefetch 	True if the tile is not needed yet
+	 * @return          	False if there is no slot free to load into
+	 */
+	boolean tileCacheRequest( TileCache& cache, uint16_t index, boolean prefetch = false );
+
+	/**
+	 * Get a tile's data to draw. If it is not ready it is requested, and counted as late.
+	 * @param  cache 	The cache
+	 * @param  index 	The tile index
+	 * @return       	The tile data, or 0 if it is not ready
+	 */
+	const uint8_t* tileCacheGet( TileCache& cache, uint16_t index );
+
+	/**
+	 * Request the tiles that are about to scroll into view. The view is moved ahead by its
+	 * velocity, and every tile of the moved view that is not already cached is requested.
+	 * Tiles closest to the current view are requested first.
+	 * @param  cache 		The cache
+	 * @param  layer 		The tile layer (its scroll position is the view position)
+	 * @param  viewWidth 	Width of the view in pixels
+	 * @param  viewHeight 	Height of the view in pixels
+	 * @param  velocityX 	Scroll speed in pixels per frame
+	 * @param  velocityY 	Scroll speed in pixels per frame
+	 * @param  lookahead 	Number of frames to look ahead
+	 * @return 				Number of tiles requested
+	 */
+	uint16_t tilePrefetch(
+		TileCache& cache,
+		const TileLayer& layer,
+		uint16_t viewWidth,
+		uint16_t viewHeight,
+		int16_t velocityX,
+		int16_t velocityY,
+		uint8_t lookahead
+	);
+
+	/**
+	 * Render a tile layer with tiles from a cache. Tiles that are not ready are requested
+	 * and not drawn.
+	 * @param fb 		The framebuffer to draw into
+	 * @param layer 	The tile layer (its tilemap is not used)
+	 * @param cache 	The tile cache
+	 * @param clip 		Optional clip rectangle (in addition to the framebuffer bounds)
+	 */
+	void renderTileLayerCached565( Framebuffer& fb, const TileLayer& layer, TileCache& cache, const Rect* clip = 0 );
+
+	/*
+	 * ### BACKGROUND LOADING (host only)
+	 */
+	#if MAC_HOST
+
+	/**
+	 * Reads one tile
+	 * @param  index 	The tile to read
+	 * @param  dst 		Where to put the tile data (tileStride bytes)
+	 * @param  data 	User data
+	 * @return       	False if the read failed
+	 */
+	typedef boolean (*TileReadCallback)( uint16_t index, uint8_t* dst, void* data );
+
+	/**
+	 * A tilemap's tile data in a file, for tileReadFile
+	 **/
+	typedef struct TileFileS {
+		FILE* file;							// The open file
+		uint32_t offset;					// Position of the first tile in the file
+		uint32_t tileStride;				// Size of each tile in bytes
+	} TileFile;
+
+	/**
+	 * Read callback for tiles stored one after another in a file. Pass a TileFile as the data.
+	 */
+	boolean tileReadFile( uint16_t index, uint8_t* dst, void* data );
+
+	/**
+	 * Loads tiles on a background thread. Pass TileLoaderThread::request as the cache's
+	 * request callback and the loader as its data. An artificial latency can be added to
+	 * each read, to test prefetching against a slow card or network.
+	 **/
+	class TileLoaderThread {
+		public:
+			/**
+			 * Start the thread
+			 * @param read 			Reads one tile
+			 * @param data 			User data for read
+			 * @param latencyUs 	Extra time added to each read, in microseconds
+			 */
+			TileLoaderThread( TileReadCallback read, void* data = 0, uint32_t latencyUs = 0 );
+			~TileLoaderThread();
+
+			/**
+			 * Request callback for a TileCache
+			 */
+			static void request( TileCache& cache, uint16_t slot, uint16_t index, void* data );
+
+			/**
+			 * Wait until every request has been loaded
+			 */
+			void wait();
+
+			/**
+			 * Change the artificial latency
+			 */
+			void setLatency( uint32_t latencyUs ){ _latencyUs = latencyUs; }
+
+		private:
+			typedef struct JobS {
+				TileCache* cache;
+				uint16_t slot;
+				uint16_t index;
+			} Job;
+
+			void workerLoop();
+
+			TileReadCallback _read;
+			void* _readData;
+			std::atomic<uint32_t> _latencyUs;
+			std::mutex _lock;
+			std::condition_variable _wake;
+			std::condition_variable _idle;
+			std::deque<Job> _jobs;
+			boolean _busy;
+			boolean _stop;
+			std::thread _thread;
+	};
+
+	#endif
+
+} // ns
+
+#endif
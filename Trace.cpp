@@ -0,0 +1,168 @@
+/**
+ * GUI library for "mac/μac"
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ **/
+
+#include "Trace.h"
+
+#if MAC_TRACE && MAC_HOST
+	#include <chrono>
+#endif
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	#if MAC_TRACE
+
+	static TraceEvent traceEvents[MAC_TRACE_EVENTS];
+
+	#if MAC_HOST
+		static std::atomic<uint32_t> traceNext( 0 );
+		static std::atomic<uint8_t> traceThreads( 0 );
+
+		/**
+		 * Small, stable thread numbers for the trace viewer
+		 */
+		static uint8_t traceThread(){
+			static thread_local uint8_t id = traceThreads++;
+			return id;
+		}
+	#else
+		static uint32_t traceNext = 0;
+		static inline uint8_t traceThread(){ return 0; }
+	#endif
+
+	/**
+	 * The trace clock, in microseconds
+	 */
+	uint32_t traceClock(){
+		#if MAC_HOST
+			return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()
+			).count();
+		#else
+			return micros();
+		#endif
+	}
+
+	/**
+	 * Record a traced section
+	 */
+	void traceRecord( const char* name, uint32_t start, uint32_t duration, char phase ){
+		TraceEvent& e = traceEvents[ (traceNext++) % MAC_TRACE_EVENTS ];
+		e.name = name;
+		e.start = start;
+		e.duration = duration;
+		e.thread = traceThread();
+		e.phase = phase;
+	}
+
+	/**
+	 * Remove all recorded events
+	 */
+	void traceClear(){
+		traceNext = 0;
+	}
+
+	/**
+	 * The number of events in the ring buffer
+	 */
+	uint16_t traceCount(){
+		uint32_t next = traceNext;
+		return (next < MAC_TRACE_EVENTS) ? next : MAC_TRACE_EVENTS;
+	}
+
+	/**
+	 * Get a recorded event, oldest first
+	 */
+	const TraceEvent& traceEvent( uint16_t index ){
+		uint32_t next = traceNext;
+		return traceEvents[ (next - traceCount() + index) % MAC_TRACE_EVENTS ];
+	}
+
+	/**
+	 * Write the recorded events as Chrome trace_event JSON
+	 */
+	void traceExportJSON( Print& out ){
+		char line[160];
+		uint16_t count = traceCount();
+		out.print( "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" );
+		for (uint16_t i = 0; i < count; i++){
+			const TraceEvent& e = traceEvent( i );
+			if (e.phase == 'X'){
+				snprintf( line, sizeof(line), "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%lu,\"dur\":%lu,\"pid\":0,\"tid\":%u}%s\n",
+					e.name, (unsigned long)e.start, (unsigned long)e.duration, e.thread, (i + 1 < count) ? "," : "" );
+			}
+			else{
+				snprintf( line, sizeof(line), "{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%lu,\"pid\":0,\"tid\":%u}%s\n",
+					e.name, (unsigned long)e.start, e.thread, (i + 1 < count) ? "," : "" );
+			}
+			out.print( line );
+		}
+		out.print( "]}\n" );
+	}
+
+	/**
+	 * Write the recorded events in a compact text form, one per line
+	 */
+	void traceDump( Print& out ){
+		char line[80];
+		uint16_t count = traceCount();
+		for (uint16_t i = 0; i < count; i++){
+			const TraceEvent& e = traceEvent( i );
+			snprintf( line, sizeof(line), "~T %c %s %lu %lu %u\n", e.phase, e.name, (unsigned long)e.start, (unsigned long)e.duration, e.thread );
+			out.print( line );
+		}
+	}
+
+	#if MAC_HOST
+
+	/**
+	 * Names read by traceLoad. Events point at these, so they are never freed.
+	 */
+	#define MAC_TRACE_NAMES 64
+	static char traceNames[MAC_TRACE_NAMES][32];
+	static uint8_t traceNameCount = 0;
+
+	static const char* traceName( const char* name ){
+		for (uint8_t i = 0; i < traceNameCount; i++){
+			if (strcmp( traceNames[i], name ) == 0) return traceNames[i];
+		}
+		if (traceNameCount == MAC_TRACE_NAMES) return "?";
+		strcpy( traceNames[traceNameCount], name );
+		return traceNames[traceNameCount++];
+	}
+
+	/**
+	 * Add an event from a line written by traceDump
+	 */
+	boolean traceLoad( const char* line ){
+		char name[32];
+		char phase;
+		unsigned long start, duration;
+		unsigned int thread;
+		const char* p = strstr( line, "~T " );
+		if (!p) return false;
+		if (sscanf( p, "~T %c %31[A-Za-z0-9_.:/-] %lu %lu %u", &phase, name, &start, &duration, &thread ) != 5) return false;
+		if ((phase != 'X') && (phase != 'i')) return false;
+		TraceEvent& e = traceEvents[ (traceNext++) % MAC_TRACE_EVENTS ];
+		e.name = traceName( name );
+		e.start = start;
+		e.duration = duration;
+		e.thread = thread;
+		e.phase = phase;
+		return true;
+	}
+
+	#endif
+
+	#endif
+
+} // ns
@@ -0,0 +1,180 @@
+/**
+ * Frame timeline tracing with Chrome trace_event JSON export
+ * Author: Peter "Projectitis" Vullings <peter@projectitis.com>
+ * Distributed under the MIT licence
+ *
+ * MIT LICENCE
+ * -----------
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef _MAC_TRACEH_
+#define _MAC_TRACEH_ 1
+
+#include "Bitmap.h"
+
+/**
+ * Define MAC_TRACE as 1 (before including any mac header, or on the compiler command line)
+ * to record trace markers. When it is 0 (default) MAC_TRACE_SCOPE compiles to nothing.
+ **/
+#ifndef MAC_TRACE
+	#define MAC_TRACE 0
+#endif
+
+/**
+ * Number of events kept in the trace ring buffer. When full, the oldest are overwritten.
+ **/
+#ifndef MAC_TRACE_EVENTS
+	#define MAC_TRACE_EVENTS 512
+#endif
+
+/**
+ * Define MAC_TRACE_BLITS as 1 to also record a marker for every blit and fill. These are
+ * called once per tile, so a single frame can fill the ring buffer. Off by default; the
+ * per-blit cost is still counted by the render stats.
+ **/
+#ifndef MAC_TRACE_BLITS
+	#define MAC_TRACE_BLITS 0
+#endif
+
+#if MAC_TRACE && MAC_HOST
+	#include <atomic>
+#endif
+
+/**
+ * This file is part of the mac (or μac) "Microprocessor App Creator" library.
+ * mac is a project that enables creating beautiful and useful apps on the
+ * Teensy microprocessor, but hopefully is generic enough to be ported to other
+ * microprocessor boards. The various libraries that make up mac might also
+ * be useful in other projects.
+ **/
+namespace mac{
+
+	#if MAC_TRACE
+
+	/**
+	 * A traced section of code
+	 **/
+	typedef struct TraceEventS {
+		const char* name;					// Name of the section (a string literal)
+		uint32_t start;						// Start time in microseconds
+		uint32_t duration;					// Duration in microseconds
+		uint8_t thread;						// Thread that ran the section (always 0 on device)
+		char phase;							// 'X' for a section, 'i' for an instant marker
+	} TraceEvent;
+
+	/**
+	 * The trace clock, in microseconds
+	 */
+	uint32_t traceClock();
+
+	/**
+	 * Record a traced section. Does not allocate. Safe to call from several threads on the host.
+	 * @param name 		Name of the section. Must stay valid (use a string literal).
+	 * @param start 	Start time (from traceClock)
+	 * @param duration 	Duration in microseconds
+	 * @param phase 	'X' for a section, 'i' for an instant marker
+	 */
+	void traceRecord( const char* name, uint32_t start, uint32_t duration, char phase = 'X' );
+
+	/**
+	 * Record an instant marker, such as the start of a frame
+	 * @param name 		Name of the marker. Must stay valid (use a string literal).
+	 */
+	inline void traceMark( const char* name ){
+		traceRecord( name, traceClock(), 0, 'i' );
+	}
+
+	/**
+	 * Remove all recorded events
+	 */
+	void traceClear();
+
+	/**
+	 * The number of events in the ring buffer (at most MAC_TRACE_EVENTS)
+	 */
+	uint16_t traceCount();
+
+	/**
+	 * Get a recorded event, oldest first
+	 * @param  index 	Index of the event (0 to traceCount()-1)
+	 * @return       	The event
+	 */
+	const TraceEvent& traceEvent( uint16_t index );
+
+	/**
+	 * Write the recorded events as Chrome trace_event JSON (open it in chrome://tracing or
+	 * Perfetto). Do not call while rendering.
+	 * @param out 		Where to write the JSON
+	 */
+	void traceExportJSON( Print& out );
+
+	/**
+	 * Write the recorded events in a compact text form, one per line, for example over Serial.
+	 * Feed the lines to traceLoad on the host to export them with traceExportJSON.
+	 * @param out 		Where to write the events
+	 */
+	void traceDump( Print& out );
+
+	#if MAC_HOST
+	/**
+	 * Add an event from a line written by traceDump. Other lines are ignored, so a whole
+	 * serial log can be fed in line by line.
+	 * @param  line 	The line of text
+	 * @return      	True if the line was a trace event
+	 */
+	boolean traceLoad( const char* line );
+	#endif
+
+	/**
+	 * Traces a section of code from construction until it goes out of scope
+	 **/
+	class TraceScope {
+		public:
+			TraceScope( const char* name ) : _name( name ), _start( traceClock() ) {}
+			~TraceScope(){ traceRecord( _name, _start, traceClock() - _start ); }
+		private:
+			const char* _name;
+			uint32_t _start;
+	};
+
+	#define MAC_TRACE_CONCAT2(a,b) a##b
+	#define MAC_TRACE_CONCAT(a,b) MAC_TRACE_CONCAT2(a,b)
+	#define MAC_TRACE_SCOPE(name) mac::TraceScope MAC_TRACE_CONCAT(_macTrace, __LINE__)( name )
+	#define MAC_TRACE_MARK(name) mac::traceMark( name )
+	#if MAC_TRACE_BLITS
+		#define MAC_TRACE_BLIT_SCOPE(name) MAC_TRACE_SCOPE( name )
+	#else
+		#define MAC_TRACE_BLIT_SCOPE(name) do{}while(0)
+	#endif
+
+	#else
+
+	#define MAC_TRACE_SCOPE(name) do{}while(0)
+	#define MAC_TRACE_MARK(name) do{}while(0)
+	#define MAC_TRACE_BLIT_SCOPE(name) do{}while(0)
+
+	#endif
+
+} // ns
+
+#endif
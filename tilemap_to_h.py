@@ -75,6 +75,53 @@ import re
 #										of that pixel will be used as the transparent color. Most often
 #										this is 0x0 (top-left).
 #									
+#				s-atlas
+#						Used with t-__x__. Each tile is trimmed to its visible (non-transparent)
+#						pixels and the trimmed sprites are packed into a single atlas bitmap. A
+#						rectangle table says where each sprite is and where it sits in its cell.
+#						Output is a mac::Atlas instead of a mac::Tilemap. Example:
+#						player_frames.t-32x32.s-atlas.p-8565.png
+#									
+#				c-mask
+#						Also output a 1-bit opacity mask for each tile (or for the bitmap), as a
+#						mac::HitMask called <name>_mask. A pixel is solid unless it is fully
+#						transparent (for RGB565 and RGB888, unless it is the transparent color).
+#						Used for hit testing and collisions (see Collision.h). Example:
+#						gui_icons.t-24x24.c-mask.p-8888.png
+#									
+#				n-__x__
+#						Used with t-__x__. Every run of this many tiles is one animation, with each
+#						frame shown for the given number of milliseconds. The first tile of each run
+#						is the base tile that is placed in the map. Also outputs a mac::TileFrame table
+#						called <name>_frames and a const mac::TileAnimation array called <name>_animations
+#						with <name>_animationCount entries. These are copied into your own
+#						mac::TileAnimation array by tileAnimInit (see TileAnimation.h), so the header
+#						holds no mutable state. Example (runs of 4 frames, 150ms each):
+#						water.t-16x16.n-4x150.p-565.png
+#									
+#				m-_
+#						Also output pre-downscaled levels of the tiles for drawing at a reduced scale.
+#						m-2 adds a half size level, m-4 adds half and quarter size levels. Each level
+#						is box filtered, weighting color by alpha. Tile sizes must divide evenly.
+#						Outputs <name>_half, <name>_quarter and a mac::TileMips called <name>_mips
+#						(see Mipmap.h). Example:
+#						world.t-16x16.m-4.p-565.png
+#									
+#				z-lz
+#						Compress the pixel data in blocks, in the LZ4 block format. For tiled images
+#						each tile is a block, so any tile can be decoded on its own. For single images
+#						each block is a band of rows. Output is a mac::CompressedTilemap instead of a
+#						mac::Tilemap (see Compress.h). Cannot be used with m-_. Example:
+#						splash.z-lz.p-565.png
+#									
+#				d-___
+#						Used with t-__x__. Each tile is one frame of a full screen animation, shown for
+#						the given number of milliseconds. The first frame is stored whole, and each
+#						frame after it only as the rectangles that changed. Pixels are always RGB565.
+#						Output is a mac::DeltaAnimation instead of a mac::Tilemap (see DeltaAnimation.h).
+#						Example (25 frames per second):
+#						boot_splash.t-320x240.d-40.png
+#									
 	
 # Define some pixel formatting functions
 # 565 as two 8-bit unsigned int
@@ -124,6 +171,434 @@ def slugify(text):
     text = text.lower()
     return re.sub(r'[\W_]+', '_', text)
 
+# Get the numeric value of a transparent color option (mac::RGB565_Transparent, 0xFF00FF etc)
+def transparentValue( trns ):
+	if trns == 'mac::RGB565_Transparent': return 0xf81f
+	if trns == 'mac::RGB888_Transparent': return 0xff00ff
+	return int(trns,16) if trns.startswith('0x') else int(trns)
+
+# Convert the pixels of one cell of the image. Returns a list of pixels (each a list of
+# bytes) and a matching list of whether each pixel is transparent. For formats with a
+# transparent key color, only key pixels are transparent (source alpha is not drawn).
+def readCell( im, alpha, convertFunc, key, left, top, w, h ):
+	pixels = []
+	clear = []
+	a = 255
+	for y in range(h):
+		for x in range(w):
+			if alpha:
+				r,g,b,a = im.getpixel((left+x,top+y))
+			else:
+				r,g,b = im.getpixel((left+x,top+y))
+			px = convertFunc(a,r,g,b)
+			pixels.append(px)
+			if key is not None:
+				clear.append(int.from_bytes(bytes(px),'big') == key)
+			else:
+				clear.append(a == 0)
+	return pixels, clear
+
+# Find the bounds of the visible pixels in a cell as x,y,w,h (w and h are 0 if empty)
+def trimCell( clear, w, h ):
+	xs = [i % w for i in range(w*h) if not clear[i]]
+	ys = [i // w for i in range(w*h) if not clear[i]]
+	if not xs: return 0,0,0,0
+	return min(xs), min(ys), max(xs)-min(xs)+1, max(ys)-min(ys)+1
+
+# Pack rectangles into a bin of the given width using a skyline (bottom-left) packer.
+# Returns the position of each rectangle and the height of the bin.
+def packSkyline( sizes, binwidth ):
+	skyline = [[0, 0, binwidth]]		# segments of x, y, width
+	pos = [(0,0)] * len(sizes)
+	order = sorted(range(len(sizes)), key=lambda i: (-sizes[i][1], -sizes[i][0]))
+	for i in order:
+		w,h = sizes[i]
+		if w == 0 or h == 0: continue
+		best = None
+		for s in range(len(skyline)):
+			x = skyline[s][0]
+			if x + w > binwidth: break
+			# Resting height over all segments the rectangle spans
+			y, span, j = 0, 0, s
+			while span < w:
+				y = max(y, skyline[j][1])
+				span += skyline[j][2]
+				j += 1
+			if best is None or y < best[1]:
+				best = (x, y, s)
+		if best is None: return None, 0
+		x, y, s = best
+		pos[i] = (x,y)
+		# Raise the skyline under the new rectangle
+		skyline.insert(s, [x, y+h, w])
+		j = s + 1
+		while j < len(skyline) and skyline[j][0] < x + w:
+			cut = x + w - skyline[j][0]
+			if cut >= skyline[j][2]:
+				skyline.pop(j)
+			else:
+				skyline[j][0] += cut
+				skyline[j][2] -= cut
+				break
+		# Merge neighbours at the same height
+		j = 0
+		while j < len(skyline)-1:
+			if skyline[j][1] == skyline[j+1][1]:
+				skyline[j][2] += skyline.pop(j+1)[2]
+			else:
+				j += 1
+	height = max([pos[i][1]+sizes[i][1] for i in range(len(sizes))] + [0])
+	return pos, height
+
+# Try a range of bin widths and keep the packing with the smallest area
+def packAtlas( sizes ):
+	maxw = max([s[0] for s in sizes] + [1])
+	area = sum([s[0]*s[1] for s in sizes])
+	best = None
+	for binwidth in range(maxw, max(maxw, int((area*2)**0.5)) + maxw + 1):
+		pos, height = packSkyline(sizes, binwidth)
+		if pos is None: continue
+		if best is None or binwidth*max(height,1) < best[0]*max(best[2],1):
+			best = (binwidth, pos, height)
+	return best
+
+# Format a list of bytes as the body of a C array, 36 to a line
+def byteArray( p ):
+	outstr = ''
+	for i in range(0, len(p), 36):
+		outstr += ' ' if i == 0 else ',\n'
+		outstr += ','.join(['0x{:02x}'.format(pc) for pc in p[i:i+36]])
+	return outstr + '\n'
+
+# Pack cells of transparent flags into 1-bit masks (leftmost pixel in the top bit of
+# each 32-bit word) and return the header definition
+def maskDefinition( name, cells, w, h ):
+	rowWords = (w + 31) // 32
+	words = []
+	for clear in cells:
+		for y in range(h):
+			row = [0] * rowWords
+			for x in range(w):
+				if not clear[y*w + x]:
+					row[x >> 5] |= 1 << (31 - (x & 31))
+			words += row
+	print('  Mask is',len(words)*4,'bytes');
+	outstr = '__attribute__((aligned(4))) static const uint32_t '+name+'_mask_data[] = {\n'
+	for i in range(0, len(words), 12):
+		outstr += ' ' if i == 0 else ',\n'
+		outstr += ','.join(['0x{:08x}'.format(word) for word in words[i:i+12]])
+	outstr += '\n};\n\n'
+	outstr += 'const mac::HitMask '+name+'_mask = {\n'
+	outstr += '\t.data = '+name+'_mask_data,\n'
+	outstr += '\t.width = '+str(w)+',\n'
+	outstr += '\t.height = '+str(h)+',\n'
+	outstr += '\t.count = '+str(len(cells))+',\n'
+	outstr += '\t.rowWords = '+str(rowWords)+',\n'
+	outstr += '\t.stride = '+str(rowWords*h)+',\n'
+	outstr += '};\n\n'
+	return outstr
+
+# Box filter the tiles of an image down by a factor and return the converted bytes. Color is
+# weighted by alpha. Transparent key pixels count as alpha 0, and a key pixel is output if
+# most of the pixels in the box are transparent.
+def mipLevel( im, alpha, convertFunc, key, cols, rows, tilewidth, tileheight, factor ):
+	lw, lh = tilewidth//factor, tileheight//factor
+	n = factor*factor
+	empty = convertFunc(0,0,0,0) if key is None else list(key.to_bytes(len(convertFunc(0,0,0,0)),'big'))
+	p = []
+	for row in range(rows):
+		for col in range(cols):
+			for y in range(lh):
+				for x in range(lw):
+					sa, sr, sg, sb = 0, 0, 0, 0
+					for v in range(factor):
+						for u in range(factor):
+							xy = (col*tilewidth + x*factor + u, row*tileheight + y*factor + v)
+							if alpha:
+								r,g,b,a = im.getpixel(xy)
+							else:
+								r,g,b = im.getpixel(xy)
+								a = 255
+							if key is not None:
+								a = 0 if int.from_bytes(bytes(convertFunc(255,r,g,b)),'big') == key else 255
+							sa += a
+							sr += r*a
+							sg += g*a
+							sb += b*a
+					if sa == 0 or (key is not None and sa*2 < n*255):
+						p += empty
+					else:
+						p += convertFunc((sa + n//2)//n, (sr + sa//2)//sa, (sg + sa//2)//sa, (sb + sa//2)//sa)
+	return p
+
+# Output a tilemap definition for one downscaled level
+def levelDefinition( name, p, pfmt, trns, tilewidth, tileheight, count ):
+	outstr = '__attribute__((aligned(4))) static const uint8_t '+name+'_data[] = {\n'
+	outstr += byteArray(p)
+	outstr += '};\n\n'
+	outstr += 'const mac::Tilemap '+name+' = {\n'
+	outstr += '\t.pixelFormat = '+pfCodes[pfmt]+',\n'
+	outstr += '\t.transparentColor = '+trns+',\n'
+	outstr += '\t.dataSize = '+str(len(p))+',\n'
+	outstr += '\t.data = '+name+'_data,\n'
+	outstr += '\t.tileWidth = '+str(tilewidth)+',\n'
+	outstr += '\t.tileHeight = '+str(tileheight)+',\n'
+	outstr += '\t.tileCount = '+str(count)+',\n'
+	outstr += '\t.tileStride = '+str(tilewidth*tileheight*pfBits[pfmt]//8)+',\n'
+	outstr += '};\n\n'
+	return outstr
+
+# Append an LZ4 length that does not fit in a token
+def lzExtra( out, n ):
+	while n >= 255:
+		out.append(255)
+		n -= 255
+	out.append(n)
+
+# Append one LZ4 sequence: literals, then an optional match (length 0 for none)
+def lzSequence( out, literals, offset, length ):
+	ll = len(literals)
+	ml = length - 4
+	out.append((min(ll,15) << 4) | (min(ml,15) if length else 0))
+	if ll >= 15: lzExtra(out, ll - 15)
+	out += literals
+	if length:
+		out += bytes([offset & 255, offset >> 8])
+		if ml >= 15: lzExtra(out, ml - 15)
+
+# Compress bytes into one LZ4 block. Greedy, with the last position of each 4-byte sequence.
+# As the LZ4 block format requires, the last match starts at least 12 bytes before the end
+# and the last 5 bytes are always literals.
+def lzCompress( data ):
+	data = bytes(data)
+	n = len(data)
+	out = bytearray()
+	last = {}
+	i = 0
+	anchor = 0
+	while i + 12 <= n:
+		seq = data[i:i+4]
+		cand = last.get(seq)
+		last[seq] = i
+		if cand is None or i - cand > 65535:
+			i += 1
+			continue
+		m = 4
+		while i + m < n - 5 and data[cand+m] == data[i+m]: m += 1
+		lzSequence(out, data[anchor:i], i - cand, m)
+		for j in range(i + 1, min(i + m, n - 3)): last[data[j:j+4]] = j
+		i += m
+		anchor = i
+	lzSequence(out, data[anchor:], 0, 0)
+	return out
+
+# Output a compressed tilemap definition
+def compressedDefinition( name, p, pfmt, trns, tilewidth, tileheight, count, tiled ):
+	stride = tilewidth*tileheight*pfBits[pfmt]//8
+	blocksize = stride
+	if not tiled:
+		rowbytes = tilewidth*pfBits[pfmt]//8
+		blocksize = rowbytes * max(1, 2048 // rowbytes)
+	data = bytearray()
+	offsets = [0]
+	for start in range(0, len(p), blocksize):
+		data += lzCompress(p[start:start+blocksize])
+		offsets.append(len(data))
+	print('  Compressed',len(p),'bytes to',len(data)+len(offsets)*4,'in',len(offsets)-1,'blocks of',blocksize)
+	outstr = '__attribute__((aligned(4))) static const uint8_t '+name+'_data[] = {\n'
+	outstr += byteArray(data)
+	outstr += '};\n\n'
+	outstr += 'static const uint32_t '+name+'_offsets[] = {\n'
+	outstr += ',\n'.join([' '+','.join([str(o) for o in offsets[i:i+16]]) for i in range(0, len(offsets), 16)])
+	outstr += '\n};\n\n'
+	outstr += 'const mac::CompressedTilemap '+name+' = {\n'
+	outstr += '\t.tilemap = {\n'
+	outstr += '\t\t.pixelFormat = '+pfCodes[pfmt]+',\n'
+	outstr += '\t\t.transparentColor = '+trns+',\n'
+	outstr += '\t\t.dataSize = '+str(len(p))+',\n'
+	outstr += '\t\t.data = 0,\n'
+	outstr += '\t\t.tileWidth = '+str(tilewidth)+',\n'
+	outstr += '\t\t.tileHeight = '+str(tileheight)+',\n'
+	outstr += '\t\t.tileCount = '+str(count)+',\n'
+	outstr += '\t\t.tileStride = '+str(stride)+',\n'
+	outstr += '\t},\n'
+	outstr += '\t.data = '+name+'_data,\n'
+	outstr += '\t.offsets = '+name+'_offsets,\n'
+	outstr += '\t.blockCount = '+str(len(offsets)-1)+',\n'
+	outstr += '\t.blockSize = '+str(blocksize)+',\n'
+	outstr += '};\n\n'
+	return outstr
+
+# Format a list of 16-bit values as the body of a C array, 16 to a line
+def wordArray( p ):
+	outstr = ''
+	for i in range(0, len(p), 16):
+		outstr += ' ' if i == 0 else ',\n'
+		outstr += ','.join(['0x{:04x}'.format(pc) for pc in p[i:i+16]])
+	return outstr + '\n'
+
+# Find the rectangles that changed between two frames. Each band of rows is split where
+# there are enough unchanged columns, and rectangles with the same columns in the band
+# above are joined.
+def deltaRects( prev, cur, w, h ):
+	band, gap = 8, 8
+	rects = []
+	above = []
+	for by in range(0, h, band):
+		bh = min(band, h - by)
+		changed = [[prev[(by+y)*w + x] != cur[(by+y)*w + x] for x in range(w)] for y in range(bh)]
+		cols = [any(changed[y][x] for y in range(bh)) for x in range(w)]
+		segments = []
+		x = 0
+		while x < w:
+			if not cols[x]:
+				x += 1
+				continue
+			x0 = x1 = x
+			while x < w and x - x1 <= gap:
+				if cols[x]: x1 = x
+				x += 1
+			segments.append((x0, x1 + 1))
+		below = []
+		for x0,x1 in segments:
+			ys = [y for y in range(bh) if any(changed[y][x0:x1])]
+			rect = [x0, by + ys[0], x1 - x0, ys[-1] + 1 - ys[0]]
+			join = next((r for r in above if r[0] == rect[0] and r[2] == rect[2] and r[1] + r[3] == rect[1]), None)
+			if join:
+				join[3] += rect[3]
+				below.append(join)
+			else:
+				rects.append(rect)
+				below.append(rect)
+		above = below
+	return rects
+
+# Encode the rectangles of a frame as 16-bit values: count, then x, y, w, h and pixels of each
+def deltaFrame( rects, cur, w ):
+	p = [len(rects)]
+	for x0,y0,rw,rh in rects:
+		p += [x0, y0, rw, rh]
+		for y in range(y0, y0 + rh):
+			p += cur[y*w + x0 : y*w + x0 + rw]
+	return p
+
+# Encode the tiles of an image as a delta animation and return the header file contents
+def deltaHeader( name, im, alpha, cols, rows, tilewidth, tileheight, frametime ):
+	frames = []
+	for row in range(rows):
+		for col in range(cols):
+			pixels, clear = readCell(im, alpha, pixel565, None, col*tilewidth, row*tileheight, tilewidth, tileheight)
+			frames.append([(px[0] << 8) | px[1] for px in pixels])
+	p = []
+	offsets = []
+	rectcount = 0
+	for i in range(len(frames) + 1):
+		offsets.append(len(p))
+		if i == 0:
+			rects = [[0, 0, tilewidth, tileheight]]
+		else:
+			rects = deltaRects(frames[i-1], frames[i % len(frames)], tilewidth, tileheight)
+			rectcount += len(rects)
+		p += deltaFrame(rects, frames[i % len(frames)], tilewidth)
+	offsets.append(len(p))
+	print('  Animation of',len(frames),'frames is',len(p)*2,'bytes ('+str(len(p)*100//(len(frames)*tilewidth*tileheight))+'% of full frames),',rectcount,'changed rectangles')
+
+	outstr = '#ifndef _TILEMAP_'+name+'_H_\n'
+	outstr += '#define _TILEMAP_'+name+'_H_ 1\n\n'
+	outstr += '#include "DeltaAnimation.h"\n\n'
+	outstr += '__attribute__((aligned(4))) static const uint16_t '+name+'_data[] = {\n'
+	outstr += wordArray(p)
+	outstr += '};\n\n'
+	outstr += 'static const uint32_t '+name+'_frames[] = {\n'
+	outstr += ' '+','.join([str(o) for o in offsets])+'\n'
+	outstr += '};\n\n'
+	outstr += 'const mac::DeltaAnimation '+name+' = {\n'
+	outstr += '\t.data = '+name+'_data,\n'
+	outstr += '\t.frames = '+name+'_frames,\n'
+	outstr += '\t.frameCount = '+str(len(frames))+',\n'
+	outstr += '\t.width = '+str(tilewidth)+',\n'
+	outstr += '\t.height = '+str(tileheight)+',\n'
+	outstr += '\t.frameTime = '+str(frametime)+',\n'
+	outstr += '};\n\n'
+	outstr += '#endif'
+	return outstr
+
+# Output the frame table and animations for runs of tiles
+def animationDefinition( name, tileCount, frames, duration ):
+	runs = tileCount // frames
+	print('  Animating',runs,'runs of',frames,'frames at',duration,'ms');
+	outstr = 'static const mac::TileFrame '+name+'_frames[] = {\n'
+	outstr += ',\n'.join(['\t{ '+str(i)+', '+str(duration)+' }' for i in range(runs*frames)])
+	outstr += '\n};\n\n'
+	outstr += 'static const mac::TileAnimation '+name+'_animations[] = {\n'
+	outstr += ',\n'.join(['\t{ '+str(i*frames)+', '+str(i*frames)+', '+str(frames)+', 0, 0, 0 }' for i in range(runs)])
+	outstr += '\n};\n\n'
+	outstr += 'const uint16_t '+name+'_animationCount = '+str(runs)+';\n\n'
+	return outstr
+
+# Get the transparent flags of each tile of an image, for masks. These come from readCell,
+# so for key color formats a pixel is clear only if it is the key, as it is when drawn.
+def cellsClear( im, alpha, convertFunc, key, cols, rows, tilewidth, tileheight ):
+	cells = []
+	for row in range(rows):
+		for col in range(cols):
+			cells.append(readCell(im, alpha, convertFunc, key, col*tilewidth, row*tileheight, tilewidth, tileheight)[1])
+	return cells
+
+# Trim the tiles of an image to their visible pixels, pack them into an atlas and
+# return the header file contents
+def atlasHeader( name, im, alpha, convertFunc, pfmt, trns, cols, rows, tilewidth, tileheight, mask ):
+	bpp = pfBits[pfmt]//8
+	key = None if pfmt in pfAlpha.values() else transparentValue(trns)
+	empty = convertFunc(0,0,0,0) if key is None else list(key.to_bytes(bpp,'big'))
+	sprites = []
+	for row in range(rows):
+		for col in range(cols):
+			pixels, clear = readCell(im, alpha, convertFunc, key, col*tilewidth, row*tileheight, tilewidth, tileheight)
+			sprites.append((pixels,) + trimCell(clear, tilewidth, tileheight))
+	sizes = [(s[3],s[4]) for s in sprites]
+	atlaswidth, pos, atlasheight = packAtlas(sizes)
+	print('  Packed',len(sprites),'sprites into',atlaswidth,'x',atlasheight,'atlas ('+str(atlaswidth*atlasheight*100//max(1,len(sprites)*tilewidth*tileheight))+'% of grid)')
+
+	# Fill the atlas with transparent pixels, then copy in each trimmed sprite
+	atlas = [empty] * (atlaswidth*atlasheight)
+	for i,(pixels,tx,ty,tw,th) in enumerate(sprites):
+		for y in range(th):
+			for x in range(tw):
+				atlas[(pos[i][1]+y)*atlaswidth + pos[i][0]+x] = pixels[(ty+y)*tilewidth + tx+x]
+	p = [b for px in atlas for b in px]
+	print(' ',len(p),'bytes in output as 8-bit words');
+
+	outstr = '#ifndef _TILEMAP_'+name+'_H_\n'
+	outstr += '#define _TILEMAP_'+name+'_H_ 1\n\n'
+	outstr += '#include "Bitmap.h"\n\n'
+	outstr += '__attribute__((aligned(4))) static const uint8_t '+name+'_data[] = {\n'
+	outstr += byteArray(p)
+	outstr += '};\n\n'
+	# x, y, w, h, offsetX, offsetY
+	outstr += 'static const mac::AtlasRect '+name+'_rects[] = {\n'
+	for i,(pixels,tx,ty,tw,th) in enumerate(sprites):
+		outstr += '\t{ '+', '.join([str(v) for v in (pos[i][0], pos[i][1], tw, th, tx, ty)])+' },\n'
+	outstr += '};\n\n'
+	outstr += 'const mac::Atlas '+name+' = {\n'
+	outstr += '\t.bitmap = {\n'
+	outstr += '\t\t.pixelFormat = '+pfCodes[pfmt]+',\n'
+	outstr += '\t\t.transparentColor = '+trns+',\n'
+	outstr += '\t\t.dataSize = '+str(len(p))+',\n'
+	outstr += '\t\t.width = '+str(atlaswidth)+',\n'
+	outstr += '\t\t.height = '+str(atlasheight)+',\n'
+	outstr += '\t\t.data = '+name+'_data,\n'
+	outstr += '\t},\n'
+	outstr += '\t.rects = '+name+'_rects,\n'
+	outstr += '\t.count = '+str(len(sprites))+',\n'
+	outstr += '\t.cellWidth = '+str(tilewidth)+',\n'
+	outstr += '\t.cellHeight = '+str(tileheight)+',\n'
+	outstr += '};\n\n'
+	if mask:
+		outstr += maskDefinition(name, cellsClear(im, alpha, convertFunc, key, cols, rows, tilewidth, tileheight), tilewidth, tileheight)
+	outstr += '#endif'
+	return outstr
+
 # Get list of files in this folder
 resources = glob('*.png')
 resources.extend(glob('*.bmp'))
@@ -252,6 +727,26 @@ for file in list(resources):
 		# steps tiles
 		a = 255
 		convertFunc = convertPixelFuncs[pfmt]
+
+		# Option: d-___
+		# Encode the tiles as the frames of a delta animation
+		if 'd' in options:
+			outstr = deltaHeader(name, im, alpha, cols, rows, tilewidth, tileheight, int(options['d']))
+			outfile = open('./'+name+'.h', 'w')
+			outfile.write(outstr)
+			outfile.close()
+			print('  Saved as '+name+'.h');
+			continue
+
+		# Option: s-atlas
+		# Trim the tiles and pack them into an atlas instead of a grid
+		if options.get('s') == 'atlas':
+			outstr = atlasHeader(name, im, alpha, convertFunc, pfmt, trns, cols, rows, tilewidth, tileheight, options.get('c') == 'mask')
+			outfile = open('./'+name+'.h', 'w')
+			outfile.write(outstr)
+			outfile.close()
+			print('  Saved as '+name+'.h');
+			continue
 		for row in range(rows):
 			for col in range(cols):
 				# step pixels in tile
@@ -264,51 +759,97 @@ for file in list(resources):
 							r,g,b = im.getpixel((col*tilewidth+x,row*tileheight+y))
 						p += convertFunc(a,r,g,b)
 				
+		compress = options.get('z') == 'lz'
+		if compress and 'm' in options:
+			print('  WARNING: m-_ is not supported with z-lz. No levels.')
+			del options['m']
+
 		# Output to file
 		outstr += '#ifndef _TILEMAP_'+name+'_H_\n'
 		outstr += '#define _TILEMAP_'+name+'_H_ 1\n\n'
-		outstr += '#include "Bitmap.h"\n\n'
-		outstr += '__attribute__((aligned(4))) static const uint8_t '+name+'_data[] = {\n'
-		c = 0
-		tp = 0
-		f = True
-		print(' ',len(p),'bytes in output as 8-bit words');
-		# Step pixels and output in groups of 36
-		for pc in p:
-			if f:
-				outstr += ' '
-				f = False
-			else:
-				outstr += ','
-			# XXX: 2, 3 or 4 bytes instead of just one
-			outstr += '0x{:02x}'.format(pc)
-			c += 1
-			tp += 1
-			if c == 36:
-				outstr += '\n'
-				c = 0
-		outstr += '};\n\n'
+		outstr += '#include "Bitmap.h"\n'
+		outstr += '#include "TileAnimation.h"\n' if 'n' in options else ''
+		outstr += '#include "Mipmap.h"\n' if 'm' in options else ''
+		outstr += '#include "Compress.h"\n' if compress else ''
+		outstr += '\n'
+		# Option: z-lz
+		# Compress the pixel data in blocks
+		if compress:
+			outstr += compressedDefinition(name, p, pfmt, trns, tilewidth, tileheight, rows*cols, 't' in options)
+		else:
+			outstr += '__attribute__((aligned(4))) static const uint8_t '+name+'_data[] = {\n'
+			c = 0
+			tp = 0
+			f = True
+			print(' ',len(p),'bytes in output as 8-bit words');
+			# Step pixels and output in groups of 36
+			for pc in p:
+				if f:
+					outstr += ' '
+					f = False
+				else:
+					outstr += ','
+				# XXX: 2, 3 or 4 bytes instead of just one
+				outstr += '0x{:02x}'.format(pc)
+				c += 1
+				tp += 1
+				if c == 36:
+					outstr += '\n'
+					c = 0
+			outstr += '};\n\n'
 		
-		# typedef struct {
-		# 	uint8_t pixelFormat;
-		# 	uint32_t transparentColor;
-		# 	uint32_t dataSize;
-		# 	uint8_t* data;
-		# 	uint32_t tileWidth;
-		# 	uint32_t tileHeight;
-		# 	uint32_t tileCount;
-		# 	uint32_t tileStride;
-		# } Tilemap;
-		outstr += 'const mac::Tilemap '+name+' = {\n'
-		outstr += '\t.pixelFormat = '+pfCodes[pfmt]+',\n'
-		outstr += '\t.transparentColor = '+trns+',\n'
-		outstr += '\t.dataSize = '+str(tp)+',\n'
-		outstr += '\t.data = '+name+'_data,\n'
-		outstr += '\t.tileWidth = '+str(tilewidth)+',\n'
-		outstr += '\t.tileHeight = '+str(tileheight)+',\n'
-		outstr += '\t.tileCount = '+str(rows*cols)+',\n'
-		outstr += '\t.tileStride = '+str(tilewidth*tileheight)+',\n'
-		outstr += '};\n\n'
+			# typedef struct {
+			# 	uint8_t pixelFormat;
+			# 	uint32_t transparentColor;
+			# 	uint32_t dataSize;
+			# 	uint8_t* data;
+			# 	uint32_t tileWidth;
+			# 	uint32_t tileHeight;
+			# 	uint32_t tileCount;
+			# 	uint32_t tileStride;
+			# } Tilemap;
+			outstr += 'const mac::Tilemap '+name+' = {\n'
+			outstr += '\t.pixelFormat = '+pfCodes[pfmt]+',\n'
+			outstr += '\t.transparentColor = '+trns+',\n'
+			outstr += '\t.dataSize = '+str(tp)+',\n'
+			outstr += '\t.data = '+name+'_data,\n'
+			outstr += '\t.tileWidth = '+str(tilewidth)+',\n'
+			outstr += '\t.tileHeight = '+str(tileheight)+',\n'
+			outstr += '\t.tileCount = '+str(rows*cols)+',\n'
+			outstr += '\t.tileStride = '+str(tilewidth*tileheight*pfBits[pfmt]//8)+',\n'
+			outstr += '};\n\n'
+
+		# Option: c-mask
+		# Also output a 1-bit opacity mask for each tile
+		if options.get('c') == 'mask':
+			key = None if pfmt in pfAlpha.values() else transparentValue(trns)
+			outstr += maskDefinition(name, cellsClear(im, alpha, convertFunc, key, cols, rows, tilewidth, tileheight), tilewidth, tileheight)
+
+		# Option: m-_
+		# Also output half and quarter size levels
+		if 'm' in options:
+			levels = [name, '0', '0']
+			for i,factor in enumerate([2,4]):
+				if factor > int(options['m']): break
+				if (tilewidth % factor) or (tileheight % factor):
+					print('  WARNING: Tile size does not divide by',factor,'- no more levels')
+					break
+				levelname = name+('_half' if factor==2 else '_quarter')
+				key = None if pfmt in pfAlpha.values() else transparentValue(trns)
+				lp = mipLevel(im, alpha, convertFunc, key, cols, rows, tilewidth, tileheight, factor)
+				print('  Level',i+1,'is',tilewidth//factor,'x',tileheight//factor,'(',len(lp),'bytes )')
+				outstr += levelDefinition(levelname, lp, pfmt, trns, tilewidth//factor, tileheight//factor, rows*cols)
+				levels[i+1] = levelname
+			outstr += 'const mac::TileMips '+name+'_mips = {\n'
+			outstr += '\t.levels = { '+', '.join([l if l == '0' else '&'+l for l in levels])+' },\n'
+			outstr += '};\n\n'
+
+		# Option: n-__x__
+		# Also output animations for runs of tiles
+		if 'n' in options:
+			anim = [int(x) for x in options['n'].split('x')]
+			if len(anim)==2 and anim[0] > 0:
+				outstr += animationDefinition(name, rows*cols, anim[0], anim[1])
 		outstr += '#endif'
 
 		# Save